@@ -0,0 +1,92 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#include <stdlib.h>
+#include "arena.h"
+#include "utilities.h"
+
+//
+// alloc_chunk is the slow path of alloc: it starts a new chunk and returns
+// the first size bytes of it.  Requests larger than a chunk get a chunk of
+// their own, and allocation continues in the current chunk.  Chunks kept
+// by reset are used before new ones are obtained from malloc.
+//
+void *Arena::alloc_chunk(size_t size)
+{
+  size_t header = (sizeof(Chunk) + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+  Chunk *c;
+
+  if (size <= CHUNK_SIZE && spare)
+  {
+    c = spare;
+    spare = spare->next;
+  }
+  else
+  {
+    size_t bytes = size > CHUNK_SIZE ? size : CHUNK_SIZE;
+    c = (Chunk *)malloc(header + bytes);
+    if (c == NULL)
+      fatal_error("Arena: out of memory\n");
+    c->size = bytes;
+  }
+  c->next = chunks;
+  chunks = c;
+
+  char *p = (char *)c + header;
+  if (size <= CHUNK_SIZE)
+  {
+    cur = p + size;
+    end = p + c->size;
+  }
+  return p;
+}
+
+void Arena::release()
+{
+  reset();
+  while (spare)
+  {
+    Chunk *next = spare->next;
+    free(spare);
+    spare = next;
+  }
+}
+
+//
+// Oversized chunks are freed; the others go on the spare list, so a
+// program allocating about as much as the previous one does not call
+// malloc at all.
+//
+void Arena::reset()
+{
+  while (chunks)
+  {
+    Chunk *next = chunks->next;
+    if (chunks->size == CHUNK_SIZE)
+    {
+      chunks->next = spare;
+      spare = chunks;
+    }
+    else
+      free(chunks);
+    chunks = next;
+  }
+  cur = end = NULL;
+}
+
+void Arena::swap(Arena &other)
+{
+  Chunk *c = chunks, *s = spare;
+  char *p = cur, *e = end;
+  chunks = other.chunks;
+  spare = other.spare;
+  cur = other.cur;
+  end = other.end;
+  other.chunks = c;
+  other.spare = s;
+  other.cur = p;
+  other.end = e;
+}
@@ -0,0 +1,83 @@
+// -*-Mode: C++;-*-
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stddef.h>
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Arena
+//
+//  An append-only region allocator.  Memory is carved sequentially out
+//  of large chunks obtained from malloc, so objects allocated one after
+//  another sit next to each other.  Individual objects are never freed;
+//  release() returns every chunk at once.
+//
+//  void *alloc(size_t size)
+//      returns size bytes aligned for any object type.
+//
+//  void release()
+//      frees all chunks; every pointer returned by alloc becomes invalid.
+//
+//  void reset()
+//      like release, but keeps the default-size chunks for the next
+//      allocations instead of returning them to malloc.
+//
+//  void swap(Arena &other)
+//      exchanges the chunks of the two arenas, and with them everything
+//      allocated from either.
+//
+/////////////////////////////////////////////////////////////////////////
+
+class Arena
+{
+private:
+  struct Chunk
+  {
+    Chunk *next; // the previously allocated chunk
+    size_t size; // bytes after the header
+  };
+
+  Chunk *chunks; // the chunks owned by the arena, most recent first
+  Chunk *spare;  // default-size chunks kept by reset, not in use
+  char *cur;     // next free byte of the current chunk
+  char *end;     // end of the current chunk
+
+  void *alloc_chunk(size_t size);
+
+public:
+  enum
+  {
+    CHUNK_SIZE = 64 * 1024, // default size of a chunk
+    ALIGN = 16              // alignment of every allocation
+  };
+
+  Arena() : chunks(NULL), spare(NULL), cur(NULL), end(NULL) {}
+  ~Arena() { release(); }
+
+  void *alloc(size_t size)
+  {
+    size = (size + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+    if ((size_t)(end - cur) < size)
+      return alloc_chunk(size);
+    void *p = cur;
+    cur += size;
+    return p;
+  }
+
+  void release();
+  void reset();
+  void swap(Arena &other);
+
+private:
+  Arena(const Arena &);            // not copyable
+  Arena &operator=(const Arena &); // not assignable
+};
+
+#endif
@@ -0,0 +1,35 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#include "callgraph.h"
+
+void CallGraph::clear()
+{
+  functions.clear();
+  calleeLists.clear();
+}
+
+int CallGraph::addFunction(CallDecl f)
+{
+  functions.push_back(f);
+  calleeLists.push_back(std::vector<int>());
+  return functions.size() - 1;
+}
+
+void CallGraph::addCall(int caller, int callee)
+{
+  calleeLists[caller].push_back(callee);
+}
+
+void CallGraph::dump(ostream &stream) const
+{
+  for (int f = 0; f < size(); f++) {
+    stream << functions[f]->getName() << ":";
+    for (int callee : calleeLists[f])
+      stream << " " << functions[callee]->getName();
+    stream << "\n";
+  }
+}
@@ -0,0 +1,53 @@
+// -*-Mode: C++;-*-
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _CALLGRAPH_H_
+#define _CALLGRAPH_H_
+
+#include <vector>
+#include "seal-decl.h"
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  CallGraph
+//
+//  The functions of a program and who calls whom.  Functions are
+//  numbered in declaration order; a Call_class node whose name resolves
+//  to a function during semantic analysis is an edge from the function
+//  containing it to that function.
+//
+//  int addFunction(CallDecl f)
+//      adds f and returns its number.
+//
+//  void addCall(int caller, int callee)
+//      adds an edge; each pair must be added only once.
+//
+//  const std::vector<int> &callees(int f)
+//      the functions f calls, in the order the edges were added.
+//
+/////////////////////////////////////////////////////////////////////////
+
+class CallGraph
+{
+private:
+  std::vector<CallDecl> functions;
+  std::vector<std::vector<int> > calleeLists;
+
+public:
+  void clear();
+  int addFunction(CallDecl f);
+  void addCall(int caller, int callee);
+
+  int size() const { return functions.size(); }
+  CallDecl function(int f) const { return functions[f]; }
+  const std::vector<int> &callees(int f) const { return calleeLists[f]; }
+
+  // one line per function: its name and the names of its callees
+  void dump(ostream &stream) const;
+};
+
+#endif
@@ -0,0 +1,222 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#include "cfg.h"
+#include "seal-visitor.h"
+
+//
+// CfgBuilder lowers statements into the blocks of a ControlFlowGraph.
+// current is the block statements are added to.  Every block is entered
+// once and filled until the next one is entered, so the statements of
+// every block are contiguous.  The innermost loop's targets for break
+// and continue are kept on a stack.
+//
+class CfgBuilder : public SealVisitor<CfgBuilder, void>
+{
+private:
+  ControlFlowGraph &graph;
+  int current;
+  std::vector<int> breakTargets, continueTargets;
+
+public:
+  CfgBuilder(ControlFlowGraph &g) : graph(g), current(ControlFlowGraph::ENTRY) {}
+
+  // Add an empty block; it is filled once it becomes current.
+  int newBlock()
+  {
+    ControlFlowGraph::Block b;
+    b.first = b.count = 0;
+    b.firstPred = b.predCount = 0;
+    b.end = ControlFlowGraph::END_NONE;
+    b.succ[0] = b.succ[1] = -1;
+    b.condition = NULL;
+    b.ret = NULL;
+    graph.blocks.push_back(b);
+    return graph.blocks.size() - 1;
+  }
+
+  void enter(int b)
+  {
+    current = b;
+    graph.blocks[b].first = graph.stmts.size();
+  }
+
+  void jump(int target)
+  {
+    graph.blocks[current].end = ControlFlowGraph::END_JUMP;
+    graph.blocks[current].succ[0] = target;
+  }
+
+  void branch(Expr condition, int ifTrue, int ifFalse)
+  {
+    ControlFlowGraph::Block &b = graph.blocks[current];
+    b.end = ControlFlowGraph::END_BRANCH;
+    b.condition = condition;
+    b.succ[0] = ifTrue;
+    b.succ[1] = ifFalse;
+  }
+
+  // Code after a return, break or continue is unreachable; it goes into
+  // a block of its own.
+  void startUnreachable()
+  {
+    enter(newBlock());
+  }
+
+  // An expression statement.
+  void visitNode(tree_node *node)
+  {
+    Expr expr = static_cast<Expr>(node);
+    if (!expr->is_empty_Expr())
+    {
+      graph.stmts.push_back(expr);
+      graph.blocks[current].count++;
+    }
+  }
+
+  void visitStmtBlock(StmtBlock_class *block)
+  {
+    for (Stmt stmt : *block->getStmts())
+      visit(stmt);
+  }
+
+  void visitIfStmt(IfStmt_class *stmt)
+  {
+    int thenBlock = newBlock(), elseBlock = newBlock(), join = newBlock();
+    branch(stmt->getCondition(), thenBlock, elseBlock);
+    enter(thenBlock);
+    visit(stmt->getThen());
+    jump(join);
+    enter(elseBlock);
+    visit(stmt->getElse());
+    jump(join);
+    enter(join);
+  }
+
+  // A for may leave its condition and step empty; a while passes no
+  // step at all.
+  void lowerLoop(Expr condition, Expr step, StmtBlock body)
+  {
+    int header = newBlock(), bodyBlock = newBlock(), latch = newBlock(), after = newBlock();
+    jump(header);
+    enter(header);
+    if (condition->is_empty_Expr())
+      jump(bodyBlock);
+    else
+      branch(condition, bodyBlock, after);
+
+    breakTargets.push_back(after);
+    continueTargets.push_back(latch);
+    enter(bodyBlock);
+    visit(body);
+    jump(latch);
+    breakTargets.pop_back();
+    continueTargets.pop_back();
+
+    enter(latch);
+    if (step)
+      visitNode(step);
+    jump(header);
+    enter(after);
+  }
+
+  void visitWhileStmt(WhileStmt_class *stmt)
+  {
+    lowerLoop(stmt->getCondition(), NULL, stmt->getBody());
+  }
+
+  void visitForStmt(ForStmt_class *stmt)
+  {
+    visitNode(stmt->getInit());
+    lowerLoop(stmt->getCondition(), stmt->getLoop(), stmt->getBody());
+  }
+
+  void visitReturnStmt(ReturnStmt_class *stmt)
+  {
+    graph.blocks[current].end = ControlFlowGraph::END_RETURN;
+    graph.blocks[current].ret = stmt;
+    graph.blocks[current].succ[0] = ControlFlowGraph::EXIT;
+    startUnreachable();
+  }
+
+  // break and continue outside a loop are semantic errors; they are
+  // left out of the graph.
+  void visitBreakStmt(BreakStmt_class *)
+  {
+    if (breakTargets.empty())
+      return;
+    jump(breakTargets.back());
+    startUnreachable();
+  }
+
+  void visitContinueStmt(ContinueStmt_class *)
+  {
+    if (continueTargets.empty())
+      return;
+    jump(continueTargets.back());
+    startUnreachable();
+  }
+};
+
+void ControlFlowGraph::build(CallDecl f)
+{
+  blocks.clear();
+  stmts.clear();
+  preds.clear();
+
+  CfgBuilder builder(*this);
+  builder.newBlock();    // ENTRY
+  builder.newBlock();    // EXIT
+  builder.enter(ENTRY);
+  builder.visit(f->getBody());
+  builder.jump(EXIT);    // falling off the end of the body
+  blocks[EXIT].first = stmts.size();
+
+  // Lay the predecessors out block by block: count them, turn the counts
+  // into offsets, then place each edge.
+  for (Block &b : blocks)
+    for (int s : b.succ)
+      if (s >= 0)
+        blocks[s].predCount++;
+  int offset = 0;
+  for (Block &b : blocks) {
+    b.firstPred = offset;
+    offset += b.predCount;
+    b.predCount = 0;
+  }
+  preds.resize(offset);
+  for (int i = 0; i < size(); i++)
+    for (int s : blocks[i].succ)
+      if (s >= 0)
+        preds[blocks[s].firstPred + blocks[s].predCount++] = i;
+}
+
+void ControlFlowGraph::dump(ostream &stream) const
+{
+  for (int i = 0; i < size(); i++) {
+    const Block &b = blocks[i];
+    stream << "B" << i << " <-";
+    for (int p = b.firstPred; p < b.firstPred + b.predCount; p++)
+      stream << " B" << preds[p];
+    stream << "\n";
+    for (int s = b.first; s < b.first + b.count; s++)
+      stream << "  line " << stmts[s]->get_line_number() << "\n";
+    switch (b.end) {
+    case END_NONE:
+      break;
+    case END_JUMP:
+      stream << "  jump B" << b.succ[0] << "\n";
+      break;
+    case END_BRANCH:
+      stream << "  branch line " << b.condition->get_line_number()
+             << " B" << b.succ[0] << " B" << b.succ[1] << "\n";
+      break;
+    case END_RETURN:
+      stream << "  return line " << b.ret->get_line_number() << "\n";
+      break;
+    }
+  }
+}
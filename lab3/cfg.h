@@ -0,0 +1,85 @@
+// -*-Mode: C++;-*-
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _CFG_H_
+#define _CFG_H_
+
+#include <vector>
+#include "seal-decl.h"
+#include "seal-stmt.h"
+#include "seal-expr.h"
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  ControlFlowGraph
+//
+//  The basic blocks of one function body.  Block ENTRY is where the body
+//  starts and block EXIT, which is empty, is where every return and the
+//  end of the body lead.  The other blocks are numbered in the order the
+//  body is lowered; code after a return, break or continue starts a
+//  block without predecessors.
+//
+//  Everything is kept in flat arrays so that an analysis walks plain
+//  vectors: the blocks, the statements of all blocks one block after the
+//  other, and the predecessors of all blocks likewise.  A block's
+//  statements are expressions (assignments, calls, ...); the conditions
+//  of if, while and for end a block as a BRANCH instead.
+//
+//  void build(CallDecl f)
+//      lowers the body of f, replacing the previous graph.  The arrays
+//      keep their memory, so one graph can be rebuilt for every function.
+//
+//  const Block &block(int b)
+//      block b; its statements are stmt(first) .. stmt(first + count - 1)
+//      and its predecessors pred(firstPred) .. pred(firstPred + predCount - 1).
+//
+/////////////////////////////////////////////////////////////////////////
+
+class ControlFlowGraph
+{
+public:
+  enum { ENTRY = 0, EXIT = 1 };
+
+  // How control leaves a block.
+  enum Terminator
+  {
+    END_NONE,    // the EXIT block
+    END_JUMP,    // to succ[0]
+    END_BRANCH,  // to succ[0] if condition is true, else to succ[1]
+    END_RETURN   // returns through ret, to EXIT
+  };
+
+  struct Block
+  {
+    int first, count;
+    int firstPred, predCount;
+    Terminator end;
+    int succ[2];     // -1 if unused
+    Expr condition;  // END_BRANCH only
+    ReturnStmt ret;  // END_RETURN only
+  };
+
+private:
+  std::vector<Block> blocks;
+  std::vector<Stmt> stmts;
+  std::vector<int> preds;
+
+  friend class CfgBuilder;
+
+public:
+  void build(CallDecl f);
+
+  int size() const { return blocks.size(); }
+  const Block &block(int b) const { return blocks[b]; }
+  Stmt stmt(int i) const { return stmts[i]; }
+  int pred(int i) const { return preds[i]; }
+
+  // one paragraph per block: its statements' lines and its successors
+  void dump(ostream &stream) const;
+};
+
+#endif
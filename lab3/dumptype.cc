@@ -4,6 +4,7 @@
 //
 #include "copyright.h"
 
+#include <vector>
 #include "seal.h"
 #include "tree.h"
 #include "seal-decl.h"
@@ -151,16 +152,19 @@ void dump_line(ostream& stream, int n, tree_node *t)
 //  "classes->nth(i)->dump_with_types(...)" shows how useful
 //  and compact virtual functions are for this kind of computation.
 //
-//  Note the use of the iterator to cycle through all of the
-//  classes.  The methods first, more, next, and nth on AST lists
-//  are defined in tree.h.
+//  Note the use of the range-based for loop to cycle through all of
+//  the declarations.  The iterators (begin and end) and the methods
+//  first, more, next, and nth on AST lists are defined in tree.h.
 //
 void Program_class::dump_with_types(ostream& stream, int n)
 {
    dump_line(stream,n,this);
    stream << pad(n) << "Program\n";
-   for(int i = decls->first(); decls->more(i); i = decls->next(i)){
-      decls->nth(i)->dump_with_types(stream, n+2);
+   for(Decl decl : *decls){
+      // semant -P leaves the functions main never calls unchecked
+      if (decl->isCallDecl() && !CallDecl(decl)->isReachable())
+         continue;
+      decl->dump_with_types(stream, n+2);
    }
      
 }
@@ -191,8 +195,8 @@ void CallDecl_class::dump_with_types(ostream& stream, int n)
    dump_Symbol(stream, n+2, name);
    stream << pad(n+2) << "(parameters)\n";
    stream << pad(n+2) << "(\n";
-   for(int i = paras->first(); paras->more(i); i = paras->next(i))
-     paras->nth(i)->dump_with_types(stream, n+2);
+   for(Variable para : *paras)
+     para->dump_with_types(stream, n+2);
    stream << pad(n+2) << ")\n";
    stream << pad(n+2) << "(return type)\n";
    dump_Symbol(stream, n+2, returnType);
@@ -207,13 +211,13 @@ void StmtBlock_class::dump_with_types(ostream& stream, int n)
    stream << pad(n) << "Statement Block\n";
    stream << pad(n+2) << "(variable declarations)\n";
    stream << pad(n+2) << "(\n";
-   for(int i = vars->first(); vars->more(i); i = vars->next(i))
-     vars->nth(i)->dump_with_types(stream, n+2);
+   for(VariableDecl var : *vars)
+     var->dump_with_types(stream, n+2);
    stream << pad(n+2) << ")\n";
    stream << pad(n+2) << "(statements)\n";
    stream << pad(n+2) << "(\n";
-   for(int i = stmts->first(); stmts->more(i); i = stmts->next(i))
-     stmts->nth(i)->dump_with_types(stream, n+2);
+   for(Stmt stmt : *stmts)
+     stmt->dump_with_types(stream, n+2);
    stream << pad(n+2) << ")\n";
 }
 
@@ -274,211 +278,236 @@ void ReturnStmt_class::dump_with_types(ostream& stream, int n)
    value->dump_with_types(stream, n+2);
 }
 
+//
+//  Expressions are dumped from an explicit stack instead of by recursion,
+//  so that deeply nested expressions cannot overflow the native stack.
+//  Each frame holds an expression, its indentation and the number of
+//  children already pushed.  Leaves are printed by their own
+//  dump_with_types; every other expression class forwards to
+//  dump_expr_with_types.
+//
+
+struct DumpFrame {
+   Expr expr;
+   int n;
+   int next;
+};
+
+static bool is_leaf(Expr e)
+{
+   switch (e->get_kind()) {
+   case NODE_CONST_INT:
+   case NODE_CONST_STRING:
+   case NODE_CONST_FLOAT:
+   case NODE_CONST_BOOL:
+   case NODE_OBJECT:
+   case NODE_NO_EXPR:
+      return true;
+   default:
+      return false;
+   }
+}
+
+static const char *operator_sign(NodeKind kind)
+{
+   switch (kind) {
+   case NODE_ADD:    return "+";
+   case NODE_MINUS:  return "-";
+   case NODE_MULTI:  return "*";
+   case NODE_DIVIDE: return "/";
+   case NODE_MOD:    return "%";
+   case NODE_NEG:    return "-";
+   case NODE_LT:     return "<";
+   case NODE_LE:     return "<=";
+   case NODE_EQU:    return "==";
+   case NODE_NEQ:    return "!=";
+   case NODE_GE:     return ">=";
+   case NODE_GT:     return ">";
+   case NODE_AND:    return "&&";
+   case NODE_OR:     return "||";
+   case NODE_XOR:    return "^";
+   case NODE_NOT:    return "!";
+   case NODE_BITAND: return "&";
+   case NODE_BITOR:  return "|";
+   case NODE_BITNOT: return "~";
+   default:          return NULL;
+   }
+}
+
+// what comes before the first child
+static void dump_expr_header(ostream& stream, int n, Expr e)
+{
+   dump_line(stream,n,e);
+   switch (e->get_kind()) {
+   case NODE_ASSIGN:
+      stream << pad(n) << "Assign\n";
+      stream << pad(n+2) << "(left value)\n";
+      dump_Symbol(stream, n+2, static_cast<Assign_class *>(e)->getLValue());
+      stream << pad(n+2) << "(right value)\n";
+      break;
+   case NODE_CALL:
+      stream << pad(n) << "Call\n";
+      stream << pad(n+2) << "(name)\n";
+      dump_Symbol(stream, n+2, static_cast<Call_class *>(e)->getName());
+      stream << pad(n+2) << "(actual parameters)\n";
+      stream << pad(n+2) << "(\n";
+      break;
+   case NODE_ACTUAL:
+      stream << pad(n) << "Actual\n";
+      stream << pad(n+2) << "(expr)\n";
+      break;
+   case NODE_NEG:
+   case NODE_NOT:
+   case NODE_BITNOT:
+      stream << pad(n) << operator_sign(e->get_kind()) << "\n";
+      stream << pad(n+2) << "(OP)\n";
+      break;
+   default:
+      stream << pad(n) << operator_sign(e->get_kind()) << "\n";
+      stream << pad(n+2) << "(OP left)\n";
+      break;
+   }
+}
+
+// what comes after the last child
+static void dump_expr_trailer(ostream& stream, int n, Expr e)
+{
+   switch (e->get_kind()) {
+   case NODE_CALL:
+      stream << pad(n+2) << ")\n";
+      stream << pad(n+2) << "(type)\n";
+      e->dump_type(stream,n);
+      break;
+   case NODE_ASSIGN:
+   case NODE_ACTUAL:
+   case NODE_ADD:
+   case NODE_MINUS:
+   case NODE_MULTI:
+   case NODE_DIVIDE:
+   case NODE_MOD:
+   case NODE_NEG:
+   case NODE_LT:
+      stream << pad(n+2) << "(type)\n";
+      e->dump_type(stream,n);
+      break;
+   default:
+      // the other comparison, logical and bitwise operators do not print the type
+      stream << pad(n+2) << "(type)\n";
+      break;
+   }
+}
+
+static void dump_expr_with_types(ostream& stream, int n, Expr root)
+{
+   std::vector<DumpFrame> stack;
+   stack.push_back(DumpFrame{root, n, 0});
+   while (!stack.empty()) {
+      DumpFrame &frame = stack.back();
+      Expr e = frame.expr;
+      if (is_leaf(e)) {
+         e->dump_with_types(stream, frame.n);
+         stack.pop_back();
+         continue;
+      }
+      if (frame.next == 0)
+         dump_expr_header(stream, frame.n, e);
+      else if (frame.next == 1 && e->get_kind() != NODE_CALL && e->getChild(1))
+         stream << pad(frame.n+2) << "(OP right)\n";
+      Expr child = e->getChild(frame.next);
+      if (child) {
+         int child_n = frame.n + 2;
+         frame.next++;
+         stack.push_back(DumpFrame{child, child_n, 0});
+      } else {
+         dump_expr_trailer(stream, frame.n, e);
+         stack.pop_back();
+      }
+   }
+}
+
 void Assign_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "Assign\n";
-   stream << pad(n+2) << "(left value)\n";
-   dump_Symbol(stream, n+2, lvalue);
-   stream << pad(n+2) << "(right value)\n";
-   value->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
-   dump_type(stream,n);
+   dump_expr_with_types(stream, n, this);
 }
 
 void Add_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "+\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
-   dump_type(stream,n);
+   dump_expr_with_types(stream, n, this);
 }
 
 void Minus_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "-\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
-   dump_type(stream,n);
+   dump_expr_with_types(stream, n, this);
 }
 
 void Multi_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "*\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
-   dump_type(stream,n);
+   dump_expr_with_types(stream, n, this);
 }
 void Divide_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "/\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
-   dump_type(stream,n);
+   dump_expr_with_types(stream, n, this);
 }
 void Mod_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "%\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
-   dump_type(stream,n);
+   dump_expr_with_types(stream, n, this);
 }
 void Neg_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "-\n";
-   stream << pad(n+2) << "(OP)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
-   dump_type(stream,n);
+   dump_expr_with_types(stream, n, this);
 }
 void Lt_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "<\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
-   dump_type(stream,n);
+   dump_expr_with_types(stream, n, this);
 }
 void Le_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "<=\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
+   dump_expr_with_types(stream, n, this);
 }
 void Equ_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "==\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
+   dump_expr_with_types(stream, n, this);
 }
 void Neq_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "!=\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
+   dump_expr_with_types(stream, n, this);
 }
 void Ge_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << ">=\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
+   dump_expr_with_types(stream, n, this);
 }
 void Gt_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << ">\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
+   dump_expr_with_types(stream, n, this);
 }
 void And_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "&&\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
+   dump_expr_with_types(stream, n, this);
 }
 void Or_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "||\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
+   dump_expr_with_types(stream, n, this);
 }
 void Xor_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "^\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
+   dump_expr_with_types(stream, n, this);
 }
 void Not_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "!\n";
-   stream << pad(n+2) << "(OP)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
+   dump_expr_with_types(stream, n, this);
 }
 void Bitand_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "&\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
+   dump_expr_with_types(stream, n, this);
 }
 void Bitor_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "|\n";
-   stream << pad(n+2) << "(OP left)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(OP right)\n";
-   e2->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
+   dump_expr_with_types(stream, n, this);
 }
 
 void Bitnot_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "~\n";
-   stream << pad(n+2) << "(OP)\n";
-   e1->dump_with_types(stream, n+2);
-   stream << pad(n+2) << "(type)\n";
+   dump_expr_with_types(stream, n, this);
 }
 
 void Object_class::dump_with_types(ostream& stream, int n)
@@ -494,27 +523,12 @@ void Object_class::dump_with_types(ostream& stream, int n)
 
 void Call_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "Call\n";
-   stream << pad(n+2) << "(name)\n";
-   dump_Symbol(stream, n+2, name);
-   stream << pad(n+2) << "(actual parameters)\n";
-   stream << pad(n+2) << "(\n";
-   for(int i = actuals->first(); actuals->more(i); i = actuals->next(i))
-     actuals->nth(i)->dump_with_types(stream, n+2);
-   stream << pad(n+2) << ")\n";
-   stream << pad(n+2) << "(type)\n";
-   dump_type(stream,n);
+   dump_expr_with_types(stream, n, this);
 }
 
 void Actual_class::dump_with_types(ostream& stream, int n)
 {
-   dump_line(stream,n,this);
-   stream << pad(n) << "Actual\n";
-   stream << pad(n+2) << "(expr)\n";
-   expr->dump_with_types(stream,n+2);
-   stream << pad(n+2) << "(type)\n";
-   dump_type(stream,n);
+   dump_expr_with_types(stream, n, this);
 }
 
 void Const_int_class::dump_with_types(ostream& stream, int n)
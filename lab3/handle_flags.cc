@@ -25,7 +25,15 @@
 extern int yy_flex_debug;       // for the lexer; prints recognized rules
 extern int seal_yydebug;        // for the parser
        int lex_verbose;         // also for the lexer; prints tokens
+       int lex_benchmark;       // time the scanner instead of compiling
+       int lex_pipeline;        // run the lexer on a thread of its own
        int semant_debug;        // for semantic analysis
+       int semant_jobs;         // threads checking function bodies, 0 = one per
+                                // core for one file, one in batch and server mode
+       int semant_prune;        // check only the functions reachable from main
+       char *manifest_filename; // file listing the input files of a batch
+       char *server_socket;     // path of the compile server's socket
+       char *token_filename;    // where to write the input's tokens
        int cgen_debug;          // for code gen
        bool disable_reg_alloc;  // Don't do register allocation
 
@@ -47,13 +55,20 @@ void handle_flags(int argc, char *argv[]) {
   yy_flex_debug = 0;
   seal_yydebug = 0;
   lex_verbose  = 0;
+  lex_benchmark = 0;
+  lex_pipeline = 0;
   semant_debug = 0;
+  semant_jobs = 0;
+  semant_prune = 0;
+  manifest_filename = NULL;
+  server_socket = NULL;
+  token_filename = NULL;
   cgen_debug = 0;
   cgen_optimize = 0;
   disable_reg_alloc = 0;
   
 
-  while ((c = getopt(argc, argv, "lpscvrOo:gtT")) != -1) {
+  while ((c = getopt(argc, argv, "lpscvrOo:gtTPLxj:m:S:w:")) != -1) {
     switch (c) {
 #ifdef DEBUG
     case 'l':
@@ -93,6 +108,27 @@ void handle_flags(int argc, char *argv[]) {
     case 'T':  // do even more pedantic tests in garbage collection
       cgen_Memmgr_Debug = GC_DEBUG;
       break;
+    case 'j':  // number of threads for semantic analysis
+      semant_jobs = atoi(optarg);
+      break;
+    case 'L':  // scan the input files with and without the fast paths
+      lex_benchmark = 1;
+      break;
+    case 'x':  // lex on one thread while parsing on another
+      lex_pipeline = 1;
+      break;
+    case 'P':  // skip the functions main never calls
+      semant_prune = 1;
+      break;
+    case 'm':  // read the names of the input files from a manifest
+      manifest_filename = optarg;
+      break;
+    case 'S':  // serve compile requests on a Unix domain socket
+      server_socket = optarg;
+      break;
+    case 'w':  // write the input's tokens to a token stream (token-stream.h)
+      token_filename = optarg;
+      break;
     case 'o':  // set the name of the output file
       out_filename = optarg;
       break;
@@ -108,12 +144,17 @@ void handle_flags(int argc, char *argv[]) {
     }
   }
 
+  // -w turns exactly one input file into a token stream; check before
+  // the stream is created, which truncates it.
+  if (token_filename != NULL && argc - optind != 1)
+    unknownopt = 1;
+
   if (unknownopt) {
       cerr << "usage: " << argv[0] << 
 #ifdef DEBUG
-	  " [-lvpscOgtTr -o outname] [input-files]\n";
+	  " [-lvpscOgtTrPLx -j jobs -m manifest -S socket -w tokens -o outname] [input-files]\n";
 #else
-      " [-OgtT -o outname] [input-files]\n";
+      " [-OgtTPLx -j jobs -m manifest -S socket -w tokens -o outname] [input-files]\n";
 #endif
       exit(1);
   }
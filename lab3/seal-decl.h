@@ -12,7 +12,7 @@ public:
    virtual Decl copy_Decl() = 0;
    virtual void dump_with_types(ostream &, int) = 0;
    virtual void dump(ostream &, int) = 0;
-   virtual bool isCallDecl() = 0;
+   bool isCallDecl() { return kind == NODE_CALL_DECL; }
    virtual Symbol getName() = 0;
    virtual Symbol getType() = 0;
    virtual void check() = 0;
@@ -27,6 +27,7 @@ protected:
 public:
    Variable_class(Symbol a1, Symbol a2)
    {
+      kind = NODE_VARIABLE;
       type = a1;
       name = a2;
    }
@@ -47,6 +48,7 @@ protected:
 public:
    VariableDecl_class(Variable a1)
    {
+      kind = NODE_VARIABLE_DECL;
       variable = a1;
    }
    Symbol getName() { return variable->getName(); }
@@ -56,7 +58,6 @@ public:
    void check();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   bool isCallDecl() { return false; };
 };
 
 class CallDecl_class : public Decl_class
@@ -66,10 +67,15 @@ protected:
    Variables paras;
    Symbol returnType;
    StmtBlock body;
+   int frameSize; // number of local slots, set by semantic analysis
+   bool reachable; // false if semant -P found main never calls it
 
 public:
    CallDecl_class(Symbol a1, Variables a2, Symbol a3, StmtBlock a4)
    {
+      frameSize = 0;
+      reachable = true;
+      kind = NODE_CALL_DECL;
       name = a1;
       paras = a2;
       returnType = a3;
@@ -80,12 +86,15 @@ public:
    Symbol getType() { return returnType; }
    Variables getVariables() { return paras; }
    StmtBlock getBody() { return body; }
+   int getFrameSize() { return frameSize; }
+   void setFrameSize(int n) { frameSize = n; }
+   bool isReachable() { return reachable; }
+   void setReachable(bool r) { reachable = r; }
 
    Decl copy_Decl();
    void check();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   bool isCallDecl() { return true; }
 };
 
 typedef class Decl_class *Decl;
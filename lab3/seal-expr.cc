@@ -2,6 +2,18 @@
 #include "seal-decl.h"
 #include "seal-expr.h"
 #include "seal-stmt.h"
+#include "seal-visitor.h"
+
+//
+// Expr_class::getChild
+//
+// Returns the n-th subexpression of an expression; see ExprChild in
+// seal-visitor.h.
+//
+Expr Expr_class::getChild(int n)
+{
+   return ExprChild(n).visit(this);
+}
 
 
 Expr Assign_class::copy_Expr()
@@ -12,6 +12,19 @@ typedef class Actual_class *Actual;
 typedef class Object_class *Object;
 typedef class Call_class *Call;
 
+// Where the variable named by an Object or an Assign lives, as resolved by
+// semantic analysis.  The slot is the index of a global, the position of a
+// parameter, the offset of a local in its function's frame, or the index
+// of a function.  Unresolved names keep SLOT_NONE.
+enum SlotKind
+{
+   SLOT_NONE,
+   SLOT_GLOBAL,
+   SLOT_PARAM,
+   SLOT_LOCAL,
+   SLOT_FUNCTION
+};
+
 class Expr_class : public Stmt_class
 {
 public:
@@ -34,8 +47,9 @@ public:
    virtual void dump_with_types(ostream &, int) = 0;
    virtual void dump(ostream &, int) = 0;
    virtual Expr copy_Expr() = 0;
-   virtual Symbol checkType() = 0;
-   virtual bool is_empty_Expr() = 0;
+   Symbol checkType();
+   bool is_empty_Expr() { return kind == NODE_NO_EXPR; }
+   Expr getChild(int n);
 };
 
 class Call_class : public Expr_class
@@ -47,17 +61,16 @@ protected:
 public:
    Call_class(Symbol a1, Actuals a2)
    {
+      kind = NODE_CALL;
       name = a1;
       actuals = a2;
    }
    Symbol getName() { return name; }
    Actuals getActuals() { return actuals; }
-   bool is_empty_Expr() { return false; }
    Expr copy_Expr();
    void dump_with_types(ostream &, int);
    void dump(ostream &, int);
    void dump_type(ostream &, int);
-   Symbol checkType();
 };
 
 class Actual_class : public Expr_class
@@ -68,14 +81,14 @@ protected:
 public:
    Actual_class(Expr a1)
    {
+      kind = NODE_ACTUAL;
       expr = a1;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getExpr() { return expr; }
    Expr copy_Expr();
    void dump_with_types(ostream &, int);
    void dump(ostream &, int);
    void dump_type(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - expr
@@ -84,18 +97,30 @@ class Assign_class : public Expr_class
 protected:
    Symbol lvalue;
    Expr value;
+   SlotKind slotKind;
+   int slot;
 
 public:
    Assign_class(Symbol a1, Expr a2)
    {
+      kind = NODE_ASSIGN;
       lvalue = a1;
       value = a2;
+      slotKind = SLOT_NONE;
+      slot = -1;
+   }
+   Symbol getLValue() { return lvalue; }
+   Expr getValue() { return value; }
+   SlotKind getSlotKind() { return slotKind; }
+   int getSlot() { return slot; }
+   void setSlot(SlotKind k, int s)
+   {
+      slotKind = k;
+      slot = s;
    }
-   bool is_empty_Expr() { return false; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - add
@@ -108,14 +133,15 @@ protected:
 public:
    Add_class(Expr a1, Expr a2)
    {
+      kind = NODE_ADD;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - minus
@@ -128,14 +154,15 @@ protected:
 public:
    Minus_class(Expr a1, Expr a2)
    {
+      kind = NODE_MINUS;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - multi
@@ -148,14 +175,15 @@ protected:
 public:
    Multi_class(Expr a1, Expr a2)
    {
+      kind = NODE_MULTI;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - divide
@@ -168,14 +196,15 @@ protected:
 public:
    Divide_class(Expr a1, Expr a2)
    {
+      kind = NODE_DIVIDE;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - mod
@@ -188,14 +217,15 @@ protected:
 public:
    Mod_class(Expr a1, Expr a2)
    {
+      kind = NODE_MOD;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - -
@@ -207,13 +237,13 @@ protected:
 public:
    Neg_class(Expr a1)
    {
+      kind = NODE_NEG;
       e1 = a1;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getOperand() { return e1; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - <
@@ -226,14 +256,15 @@ protected:
 public:
    Lt_class(Expr a1, Expr a2)
    {
+      kind = NODE_LT;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - <=
@@ -246,14 +277,15 @@ protected:
 public:
    Le_class(Expr a1, Expr a2)
    {
+      kind = NODE_LE;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - ==
@@ -266,14 +298,15 @@ protected:
 public:
    Equ_class(Expr a1, Expr a2)
    {
+      kind = NODE_EQU;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - !=
@@ -286,14 +319,15 @@ protected:
 public:
    Neq_class(Expr a1, Expr a2)
    {
+      kind = NODE_NEQ;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - >=
@@ -306,14 +340,15 @@ protected:
 public:
    Ge_class(Expr a1, Expr a2)
    {
+      kind = NODE_GE;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - >
@@ -326,14 +361,15 @@ protected:
 public:
    Gt_class(Expr a1, Expr a2)
    {
+      kind = NODE_GT;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - and &&
@@ -346,14 +382,15 @@ protected:
 public:
    And_class(Expr a1, Expr a2)
    {
+      kind = NODE_AND;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - or ||
@@ -366,14 +403,15 @@ protected:
 public:
    Or_class(Expr a1, Expr a2)
    {
+      kind = NODE_OR;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - xor ^
@@ -386,14 +424,15 @@ protected:
 public:
    Xor_class(Expr a1, Expr a2)
    {
+      kind = NODE_XOR;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - not !
@@ -405,13 +444,13 @@ protected:
 public:
    Not_class(Expr a1)
    {
+      kind = NODE_NOT;
       e1 = a1;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getOperand() { return e1; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - bitnot ~
@@ -423,13 +462,13 @@ protected:
 public:
    Bitnot_class(Expr a1)
    {
+      kind = NODE_BITNOT;
       e1 = a1;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getOperand() { return e1; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 class Bitand_class : public Expr_class
@@ -441,14 +480,15 @@ protected:
 public:
    Bitand_class(Expr a1, Expr a2)
    {
+      kind = NODE_BITAND;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 class Bitor_class : public Expr_class
@@ -460,14 +500,15 @@ protected:
 public:
    Bitor_class(Expr a1, Expr a2)
    {
+      kind = NODE_BITOR;
       e1 = a1;
       e2 = a2;
    }
-   bool is_empty_Expr() { return false; }
+   Expr getLeft() { return e1; }
+   Expr getRight() { return e2; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructconst_int - const_int
@@ -479,13 +520,13 @@ protected:
 public:
    Const_int_class(Symbol a1)
    {
+      kind = NODE_CONST_INT;
       value = a1;
    }
-   bool is_empty_Expr() { return false; }
+   Symbol getValue() { return value; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructconst_string - const_string
@@ -497,13 +538,13 @@ protected:
 public:
    Const_string_class(Symbol a1)
    {
+      kind = NODE_CONST_STRING;
       value = a1;
    }
-   bool is_empty_Expr() { return false; }
+   Symbol getValue() { return value; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructconst_float - const_float
@@ -515,13 +556,13 @@ protected:
 public:
    Const_float_class(Symbol a1)
    {
+      kind = NODE_CONST_FLOAT;
       value = a1;
    }
-   bool is_empty_Expr() { return false; }
+   Symbol getValue() { return value; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructconst_bool - const_bool
@@ -533,31 +574,42 @@ protected:
 public:
    Const_bool_class(Boolean a1)
    {
+      kind = NODE_CONST_BOOL;
       value = a1;
    }
-   bool is_empty_Expr() { return false; }
+   Boolean getValue() { return value; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 class Object_class : public Expr_class
 {
 protected:
    Symbol var;
+   SlotKind slotKind;
+   int slot;
 
 public:
    Object_class(Symbol a1)
    {
+      kind = NODE_OBJECT;
       var = a1;
+      slotKind = SLOT_NONE;
+      slot = -1;
+   }
+   Symbol getVar() { return var; }
+   SlotKind getSlotKind() { return slotKind; }
+   int getSlot() { return slot; }
+   void setSlot(SlotKind k, int s)
+   {
+      slotKind = k;
+      slot = s;
    }
-   bool is_empty_Expr() { return false; }
    Expr copy_Expr() { return copy_Object(); };
    Object copy_Object();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 // define constructor - no_expr
@@ -567,12 +619,11 @@ protected:
 public:
    No_expr_class()
    {
+      kind = NODE_NO_EXPR;
    }
-   bool is_empty_Expr() { return true; }
    Expr copy_Expr();
    void dump(ostream &stream, int n);
    void dump_with_types(ostream &, int);
-   Symbol checkType();
 };
 
 typedef list_node<Expr> Exprs_class;
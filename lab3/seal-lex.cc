@@ -203,12 +203,12 @@ typedef size_t yy_size_t;
 #endif
 
 /* %if-not-reentrant */
-extern yy_size_t yyleng;
+extern thread_local yy_size_t yyleng;
 /* %endif */
 
 /* %if-c-only */
 /* %if-not-reentrant */
-extern FILE *yyin, *yyout;
+extern thread_local FILE *yyin, *yyout;
 /* %endif */
 /* %endif */
 
@@ -225,15 +225,12 @@ extern FILE *yyin, *yyout;
 		/* Undo effects of setting up yytext. */ \
         int yyless_macro_arg = (n); \
         YY_LESS_LINENO(yyless_macro_arg);\
-		*yy_cp = (yy_hold_char); \
 		YY_RESTORE_YY_MORE_OFFSET \
 		(yy_c_buf_p) = yy_cp = yy_bp + yyless_macro_arg - YY_MORE_ADJ; \
 		YY_DO_BEFORE_ACTION; /* set up yytext again */ \
 		} \
 	while ( 0 )
 
-#define unput(c) yyunput( c, (yytext_ptr)  )
-
 #ifndef YY_STRUCT_YY_BUFFER_STATE
 #define YY_STRUCT_YY_BUFFER_STATE
 struct yy_buffer_state
@@ -310,9 +307,9 @@ struct yy_buffer_state
 /* %if-not-reentrant */
 
 /* Stack of input buffers. */
-static size_t yy_buffer_stack_top = 0; /**< index of top of stack. */
-static size_t yy_buffer_stack_max = 0; /**< capacity of stack. */
-static YY_BUFFER_STATE * yy_buffer_stack = 0; /**< Stack as an array. */
+static thread_local size_t yy_buffer_stack_top = 0; /**< index of top of stack. */
+static thread_local size_t yy_buffer_stack_max = 0; /**< capacity of stack. */
+static thread_local YY_BUFFER_STATE * yy_buffer_stack = 0; /**< Stack as an array. */
 /* %endif */
 /* %ok-for-header */
 
@@ -338,20 +335,22 @@ static YY_BUFFER_STATE * yy_buffer_stack = 0; /**< Stack as an array. */
 /* %if-not-reentrant */
 /* %not-for-header */
 
-/* yy_hold_char holds the character lost when yytext is formed. */
-static char yy_hold_char;
-static yy_size_t yy_n_chars;		/* number of characters read into yy_ch_buf */
-yy_size_t yyleng;
+/* yy_hold_char holds the character lost when yytext is formed.  The
+ * rules do not NUL-terminate yytext, see YY_DO_BEFORE_ACTION.
+ */
+static thread_local char yy_hold_char;
+static thread_local yy_size_t yy_n_chars;		/* number of characters read into yy_ch_buf */
+thread_local yy_size_t yyleng;
 
 /* Points to current character in buffer. */
-static char *yy_c_buf_p = (char *) 0;
-static int yy_init = 0;		/* whether we need to initialize */
-static int yy_start = 0;	/* start state number */
+static thread_local char *yy_c_buf_p = (char *) 0;
+static thread_local int yy_init = 0;		/* whether we need to initialize */
+static thread_local int yy_start = 0;	/* start state number */
 
 /* Flag which is used to allow yywrap()'s to do buffer switches
  * instead of setting up a fresh yyin.  A bit of a hack ...
  */
-static int yy_did_buffer_switch_on_eof;
+static thread_local int yy_did_buffer_switch_on_eof;
 /* %ok-for-header */
 
 /* %endif */
@@ -410,19 +409,21 @@ void yyfree (void *  );
 #define yywrap() 1
 #define YY_SKIP_YYWRAP
 
+#define YY_NO_INPUT 1
+
 #define FLEX_DEBUG
 
 typedef unsigned char YY_CHAR;
 
-FILE *yyin = (FILE *) 0, *yyout = (FILE *) 0;
+thread_local FILE *yyin = (FILE *) 0, *yyout = (FILE *) 0;
 
 typedef int yy_state_type;
 
-extern int yylineno;
+extern thread_local int yylineno;
 
-int yylineno = 1;
+thread_local int yylineno = 1;
 
-extern char *yytext;
+extern thread_local char *yytext;
 #define yytext_ptr yytext
 
 /* %if-c-only Standard (non-C++) definition */
@@ -437,12 +438,14 @@ static void yy_fatal_error (yyconst char msg[]  );
 /* Done after the current pattern has been matched and before the
  * corresponding action - sets up yytext.
  */
+/* yytext is left in the buffer as it is, without a NUL after it, so the
+ * scanner never writes to a buffer given to yy_scan_buffer; the rules use
+ * yyleng.
+ */
 #define YY_DO_BEFORE_ACTION \
 	(yytext_ptr) = yy_bp; \
 /* %% [2.0] code to fiddle yytext and yyleng for yymore() goes here \ */\
 	yyleng = (size_t) (yy_cp - yy_bp); \
-	(yy_hold_char) = *yy_cp; \
-	*yy_cp = '\0'; \
 /* %% [3.0] code to copy yytext_ptr to yytext[] goes here, if %array \ */\
 	(yy_c_buf_p) = yy_cp;
 
@@ -628,8 +631,8 @@ static yyconst flex_int16_t yy_chk[277] =
       145,  145,  145,  145,  145,  145
     } ;
 
-static yy_state_type yy_last_accepting_state;
-static char *yy_last_accepting_cpos;
+static thread_local yy_state_type yy_last_accepting_state;
+static thread_local char *yy_last_accepting_cpos;
 
 extern int yy_flex_debug;
 int yy_flex_debug = 1;
@@ -652,7 +655,7 @@ static yyconst flex_int16_t yy_rule_linenum[68] =
 #define yymore() yymore_used_but_not_detected
 #define YY_MORE_ADJ 0
 #define YY_RESTORE_YY_MORE_OFFSET
-char *yytext;
+thread_local char *yytext;
 #line 1 "seal.flex"
 /*
 *  The scanner definition for seal.
@@ -678,7 +681,7 @@ char *yytext;
 #define MAX_STR_CONST 256
 #define YY_NO_UNPUT   /* keep g++ happy */
 
-extern FILE *fin; /* we read from this file */
+extern thread_local FILE *fin; /* we read from this file */
 
 /* define YY_INPUT so we read from the FILE fin:
  * This change makes it possible to use this scanner in
@@ -689,21 +692,35 @@ extern FILE *fin; /* we read from this file */
 	if ( (result = fread( (char*)buf, sizeof(char), max_size, fin)) < 0) \
 		YY_FATAL_ERROR( "read() in flex scanner failed");
 
-char string_buf[MAX_STR_CONST]; /* to assemble string constants */
-char *string_buf_ptr;
+thread_local char string_buf[MAX_STR_CONST]; /* to assemble string constants */
+thread_local char *string_buf_ptr;
 
-extern int curr_lineno;
+extern thread_local int curr_lineno;
 extern int verbose_flag;
 
-extern YYSTYPE seal_yylval;
+extern thread_local YYSTYPE seal_yylval;
 
 /*
  *  Add Your own definitions here
  */
 
-char string_const[MAX_STR_CONST + 10];
-int string_const_len;
-bool str_contain_null_char;
+thread_local char string_const[MAX_STR_CONST + 10];
+thread_local int string_const_len;
+thread_local bool str_contain_null_char;
+
+/*
+ * The fast paths of seal-scan.h, used unless lex_fast_scan is 0 or the
+ * rules are being traced.
+ */
+#include "seal-scan.h"
+
+int lex_fast_scan = 1;
+
+/* Where the lexer reports the errors that end the input.  A lexer
+ * running ahead of the parser (token-pipe.cc) holds them back until
+ * the parser gets to the bad token.
+ */
+thread_local ostream *lex_errors = &cerr;
 
 /*
 * Define names for regular expressions here.
@@ -788,12 +805,6 @@ extern int yywrap (void );
 #endif
 #endif
 
-/* %not-for-header */
-
-    static void yyunput (int c,char *buf_ptr  );
-    
-/* %ok-for-header */
-
 /* %endif */
 
 #ifndef yytext_ptr
@@ -999,8 +1010,43 @@ YY_DECL
 /* %% [8.0] yymore()-related code goes here */
 		yy_cp = (yy_c_buf_p);
 
-		/* Support of yytext. */
-		*yy_cp = (yy_hold_char);
+		/* Skip what the rules would only discard and take whole
+		 * identifiers; anything else, and the end of the buffer, is
+		 * left to the DFA.
+		 */
+		if ( lex_fast_scan && ! yy_flex_debug )
+			{
+			if ( YY_START == INITIAL )
+				{
+				if ( ScanBlank::byte(*yy_cp) )
+					yy_cp = scan_run<ScanBlank>(yy_cp, curr_lineno);
+				if ( ((*yy_cp | 0x20) >= 'a' && (*yy_cp | 0x20) <= 'z') )
+					{
+					int lines = 0;
+					char *end = ScanIdentifier::byte(yy_cp[1]) ?
+						scan_run<ScanIdentifier>(yy_cp + 1, lines) : yy_cp + 1;
+					int len = end - yy_cp;
+					const ScanWord *word = *end ? scan_word(yy_cp, len) : NULL;
+					int token = word ? word->token : (*end && *yy_cp >= 'a') ? OBJECTID : 0;
+					if ( token )
+						{
+						(yytext_ptr) = yy_cp;
+						yyleng = len;
+						(yy_c_buf_p) = end;
+						if ( token == OBJECTID || token == TYPEID )
+							seal_yylval.symbol = idtable.add_string(yy_cp, len);
+						else if ( token == CONST_BOOL )
+							seal_yylval.boolean = word->value;
+						return token;
+						}
+					}
+				}
+			else if ( YY_START == LINE_COMMENT )
+				yy_cp = scan_run<ScanLineComment>(yy_cp, curr_lineno);
+			else if ( YY_START == BLOCK_COMMENT )
+				yy_cp = scan_run<ScanBlockComment>(yy_cp, curr_lineno);
+			(yy_c_buf_p) = yy_cp;
+			}
 
 		/* yy_bp points to the position in yy_ch_buf of the start of
 		 * the current run.
@@ -1051,11 +1097,11 @@ do_action:	/* This label is used only to access EOF actions. */
 			if ( yy_act == 0 )
 				fprintf( stderr, "--scanner backing up\n" );
 			else if ( yy_act < 68 )
-				fprintf( stderr, "--accepting rule at line %ld (\"%s\")\n",
-				         (long)yy_rule_linenum[yy_act], yytext );
+				fprintf( stderr, "--accepting rule at line %ld (\"%.*s\")\n",
+				         (long)yy_rule_linenum[yy_act], (int) yyleng, yytext );
 			else if ( yy_act == 68 )
-				fprintf( stderr, "--accepting default rule (\"%s\")\n",
-				         yytext );
+				fprintf( stderr, "--accepting default rule (\"%.*s\")\n",
+				         (int) yyleng, yytext );
 			else if ( yy_act == 69 )
 				fprintf( stderr, "--(end of buffer or a NUL)\n" );
 			else
@@ -1066,8 +1112,6 @@ do_action:	/* This label is used only to access EOF actions. */
 	{ /* beginning of action switch */
 /* %% [13.0] actions go here */
 			case 0: /* must back up */
-			/* undo the effects of YY_DO_BEFORE_ACTION */
-			*yy_cp = (yy_hold_char);
 			yy_cp = (yy_last_accepting_cpos);
 			yy_current_state = (yy_last_accepting_state);
 			goto yy_find_action;
@@ -1121,8 +1165,8 @@ YY_RULE_SETUP
 case YY_STATE_EOF(BLOCK_COMMENT):
 #line 85 "seal.flex"
 { 
-	cerr << curr_lineno << ": Comment meets an EOF.\n";
-  exit(-1);
+	*lex_errors << curr_lineno << ": Comment meets an EOF.\n";
+  fatal_input_error(-1);
 }
 	YY_BREAK
 case 9:
@@ -1134,8 +1178,8 @@ case 10:
 YY_RULE_SETUP
 #line 90 "seal.flex"
 {
-	cerr << curr_lineno << ": Unmatched */.\n";
-  exit(-1);
+	*lex_errors << curr_lineno << ": Unmatched */.\n";
+  fatal_input_error(-1);
 }
 	YY_BREAK
 /*
@@ -1353,8 +1397,8 @@ YY_RULE_SETUP
 case YY_STATE_EOF(QUOTE_STRING):
 #line 171 "seal.flex"
 {
-	cerr << curr_lineno << ": String constant meets an EOF.\n";
-  exit(-1);
+	*lex_errors << curr_lineno << ": String constant meets an EOF.\n";
+  fatal_input_error(-1);
 }
 	YY_BREAK
 case 48:
@@ -1362,8 +1406,8 @@ YY_RULE_SETUP
 #line 176 "seal.flex"
 {
 	if (string_const_len >= MAX_STR_CONST) {
-		cerr << curr_lineno << ": String length is more than 256.\n";
-    exit(-1);
+		*lex_errors << curr_lineno << ": String length is more than 256.\n";
+    fatal_input_error(-1);
 	} 
 	
 	int r = 0;
@@ -1385,8 +1429,8 @@ YY_RULE_SETUP
 #line 196 "seal.flex"
 {
 	if (string_const_len >= MAX_STR_CONST) {
-		cerr << curr_lineno << ": String length is more than 256.\n";
-    exit(-1);
+		*lex_errors << curr_lineno << ": String length is more than 256.\n";
+    fatal_input_error(-1);
 	} 
 	
 	int r = 0;
@@ -1402,8 +1446,8 @@ YY_RULE_SETUP
 #line 210 "seal.flex"
 {
 	if (string_const_len >= MAX_STR_CONST) {
-		cerr << curr_lineno << ": String length is more than 256.\n";
-    exit(-1);
+		*lex_errors << curr_lineno << ": String length is more than 256.\n";
+    fatal_input_error(-1);
 	} 
 	switch(yytext[1]) {
 		case '\"': string_const[string_const_len++] = '\"'; break;
@@ -1424,8 +1468,8 @@ YY_RULE_SETUP
 #line 228 "seal.flex"
 { 
 	if (string_const_len >= MAX_STR_CONST) {
-		cerr << curr_lineno << ": String length is more than 256.\n";
-    exit(-1);
+		*lex_errors << curr_lineno << ": String length is more than 256.\n";
+    fatal_input_error(-1);
 	} 
 	string_const[string_const_len++] = '\n'; 
 	curr_lineno++; 
@@ -1436,8 +1480,8 @@ case 52:
 YY_RULE_SETUP
 #line 236 "seal.flex"
 {
-	cerr << curr_lineno << ": String length is more than 256.\n";
-    exit(-1);
+	*lex_errors << curr_lineno << ": String length is more than 256.\n";
+    fatal_input_error(-1);
 }
 	YY_BREAK
 case 53:
@@ -1445,8 +1489,8 @@ YY_RULE_SETUP
 #line 241 "seal.flex"
 { 
 	if (string_const_len > 0 && str_contain_null_char) {
-		cerr << curr_lineno << ": String contains a '\0'.\n";
-    exit(-1);
+		*lex_errors << curr_lineno << ": String contains a '\0'.\n";
+    fatal_input_error(-1);
 	}
 	seal_yylval.symbol = stringtable.add_string(string_const);
 	BEGIN 0; return (CONST_STRING);
@@ -1457,8 +1501,8 @@ YY_RULE_SETUP
 #line 250 "seal.flex"
 { 
 	if (string_const_len >= MAX_STR_CONST) {
-		cerr << curr_lineno << ": String length is more than 256.\n";
-    exit(-1);
+		*lex_errors << curr_lineno << ": String length is more than 256.\n";
+    fatal_input_error(-1);
 	} 
 	string_const[string_const_len++] = yytext[0]; 
 }
@@ -1478,8 +1522,8 @@ YY_RULE_SETUP
 #line 264 "seal.flex"
 {
 	if (string_const_len >= MAX_STR_CONST) {
-		cerr << curr_lineno << ": String length is more than 256.\n";
-    exit(-1);
+		*lex_errors << curr_lineno << ": String length is more than 256.\n";
+    fatal_input_error(-1);
 	} 
 	curr_lineno++;
 	string_const[string_const_len++] = yytext[0]; 
@@ -1490,8 +1534,8 @@ YY_RULE_SETUP
 #line 273 "seal.flex"
 {
 	if (string_const_len >= MAX_STR_CONST) {
-		cerr << curr_lineno << ": String length is more than 256.\n";
-    exit(-1);
+		*lex_errors << curr_lineno << ": String length is more than 256.\n";
+    fatal_input_error(-1);
 	} 
 	string_const[string_const_len++] = yytext[0]; 
 }
@@ -1501,8 +1545,8 @@ YY_RULE_SETUP
 #line 281 "seal.flex"
 {
 	if (string_const_len >= MAX_STR_CONST) {
-		cerr << curr_lineno << ": String length is more than 256.\n";
-    exit(-1);
+		*lex_errors << curr_lineno << ": String length is more than 256.\n";
+    fatal_input_error(-1);
 	} 
 	seal_yylval.symbol = stringtable.add_string(string_const);
 	BEGIN 0; return (CONST_STRING);
@@ -1511,8 +1555,8 @@ YY_RULE_SETUP
 case YY_STATE_EOF(REVERSE_STRING):
 #line 290 "seal.flex"
 {
-	cerr << curr_lineno << ": String constant meets an EOF.\n";
-    exit(-1);
+	*lex_errors << curr_lineno << ": String constant meets an EOF.\n";
+    fatal_input_error(-1);
 }
 	YY_BREAK
 /*
@@ -1522,7 +1566,7 @@ case 59:
 YY_RULE_SETUP
 #line 299 "seal.flex"
 { 
-	seal_yylval.symbol = inttable.add_string(yytext); 
+	seal_yylval.symbol = inttable.add_string(yytext, yyleng); 
 	return (CONST_INT);
 }
 	YY_BREAK
@@ -1566,7 +1610,7 @@ case 62:
 YY_RULE_SETUP
 #line 334 "seal.flex"
 {
-	seal_yylval.symbol = floattable.add_string(yytext); 
+	seal_yylval.symbol = floattable.add_string(yytext, yyleng); 
 	return (CONST_FLOAT);
 }
 	YY_BREAK
@@ -1574,7 +1618,7 @@ case 63:
 YY_RULE_SETUP
 #line 339 "seal.flex"
 {
-	seal_yylval.symbol = idtable.add_string(yytext);
+	seal_yylval.symbol = idtable.add_string(yytext, yyleng);
 	return (OBJECTID);
 }
 	YY_BREAK
@@ -1582,7 +1626,7 @@ case 64:
 YY_RULE_SETUP
 #line 344 "seal.flex"
 {
-	seal_yylval.symbol = idtable.add_string(yytext);
+	seal_yylval.symbol = idtable.add_string(yytext, yyleng);
 	return (TYPEID);
 }
 	YY_BREAK
@@ -1590,16 +1634,18 @@ case 65:
 YY_RULE_SETUP
 #line 349 "seal.flex"
 {
-	cerr << curr_lineno << ": Illegal Type name " << yytext << ".\n";
-    exit(-1);
+	*lex_errors << curr_lineno << ": Illegal Type name ";
+	lex_errors->write(yytext, yyleng) << ".\n";
+    fatal_input_error(-1);
 }
 	YY_BREAK
 case 66:
 YY_RULE_SETUP
 #line 354 "seal.flex"
 {
-	cerr << curr_lineno << ": Illegal Identifier name " << yytext << ".\n";
-    exit(-1);
+	*lex_errors << curr_lineno << ": Illegal Identifier name ";
+	lex_errors->write(yytext, yyleng) << ".\n";
+    fatal_input_error(-1);
 }
 	YY_BREAK
 /*
@@ -1609,8 +1655,9 @@ case 67:
 YY_RULE_SETUP
 #line 363 "seal.flex"
 {
-	cerr << curr_lineno << ": Illegal character " << yytext << ".\n";
-    exit(-1);
+	*lex_errors << curr_lineno << ": Illegal character ";
+	lex_errors->write(yytext, yyleng) << ".\n";
+    fatal_input_error(-1);
 }
 	YY_BREAK
 case 68:
@@ -1628,8 +1675,6 @@ case YY_STATE_EOF(LINE_COMMENT):
 		/* Amount of text matched not including the EOB char. */
 		int yy_amount_of_matched_text = (int) (yy_cp - (yytext_ptr)) - 1;
 
-		/* Undo the effects of YY_DO_BEFORE_ACTION. */
-		*yy_cp = (yy_hold_char);
 		YY_RESTORE_YY_MORE_OFFSET
 
 		if ( YY_CURRENT_BUFFER_LVALUE->yy_buffer_status == YY_BUFFER_NEW )
@@ -1974,49 +2019,6 @@ static int yy_get_next_buffer (void)
 		return yy_is_jam ? 0 : yy_current_state;
 }
 
-/* %if-c-only */
-
-    static void yyunput (int c, register char * yy_bp )
-/* %endif */
-/* %if-c++-only */
-/* %endif */
-{
-	register char *yy_cp;
-    
-    yy_cp = (yy_c_buf_p);
-
-	/* undo effects of setting up yytext */
-	*yy_cp = (yy_hold_char);
-
-	if ( yy_cp < YY_CURRENT_BUFFER_LVALUE->yy_ch_buf + 2 )
-		{ /* need to shift things up to make room */
-		/* +2 for EOB chars. */
-		register yy_size_t number_to_move = (yy_n_chars) + 2;
-		register char *dest = &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[
-					YY_CURRENT_BUFFER_LVALUE->yy_buf_size + 2];
-		register char *source =
-				&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[number_to_move];
-
-		while ( source > YY_CURRENT_BUFFER_LVALUE->yy_ch_buf )
-			*--dest = *--source;
-
-		yy_cp += (int) (dest - source);
-		yy_bp += (int) (dest - source);
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars =
-			(yy_n_chars) = YY_CURRENT_BUFFER_LVALUE->yy_buf_size;
-
-		if ( yy_cp < YY_CURRENT_BUFFER_LVALUE->yy_ch_buf + 2 )
-			YY_FATAL_ERROR( "flex scanner push-back overflow" );
-		}
-
-	*--yy_cp = (char) c;
-
-/* %% [18.0] update yylineno here */
-
-	(yytext_ptr) = yy_bp;
-	(yy_hold_char) = *yy_cp;
-	(yy_c_buf_p) = yy_cp;
-}
 /* %if-c-only */
 
 /* %endif */
@@ -2148,7 +2150,6 @@ static int yy_get_next_buffer (void)
 	if ( YY_CURRENT_BUFFER )
 		{
 		/* Flush out information for old buffer. */
-		*(yy_c_buf_p) = (yy_hold_char);
 		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = (yy_c_buf_p);
 		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
 		}
@@ -2323,7 +2324,6 @@ void yypush_buffer_state (YY_BUFFER_STATE new_buffer )
 	if ( YY_CURRENT_BUFFER )
 		{
 		/* Flush out information for old buffer. */
-		*(yy_c_buf_p) = (yy_hold_char);
 		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = (yy_c_buf_p);
 		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
 		}
@@ -2532,10 +2532,7 @@ static void yy_fatal_error (yyconst char* msg )
 		/* Undo effects of setting up yytext. */ \
         int yyless_macro_arg = (n); \
         YY_LESS_LINENO(yyless_macro_arg);\
-		yytext[yyleng] = (yy_hold_char); \
 		(yy_c_buf_p) = yytext + yyless_macro_arg; \
-		(yy_hold_char) = *(yy_c_buf_p); \
-		*(yy_c_buf_p) = '\0'; \
 		yyleng = yyless_macro_arg; \
 		} \
 	while ( 0 )
@@ -2747,3 +2744,66 @@ void yyfree (void * ptr )
 
 
 
+/*
+ * Scanning a file in place.  map_input_file maps the file into memory and
+ * gives the mapping to yy_scan_buffer, so the scanner reads the source
+ * where it lies instead of fread'ing it from fin into its own buffer.
+ * yy_scan_buffer wants two NULs after the text; the mapping is rounded up
+ * to whole pages, with an anonymous page behind the file if need be, and
+ * the bytes past the end of the file read as zero.  The scanner does not
+ * write to its buffer, so the mapping is read-only, and identifiers are
+ * copied only when they are first entered into idtable.
+ *
+ * Returns false if the file cannot be mapped (it is empty, or not a
+ * regular file); the caller then reads it through fin as usual.
+ * unmap_input_file drops the mapping once the file has been parsed.
+ */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static thread_local char *mapped_base = NULL;
+static thread_local size_t mapped_length = 0;
+
+bool map_input_file(const char *filename)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	size_t size = st.st_size;
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t length = (size + 2 + page - 1) / page * page;
+	char *base = (char *) mmap(NULL, length, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+	if (mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		munmap(base, length);
+		close(fd);
+		return false;
+	}
+	close(fd);
+	madvise(base, size, MADV_SEQUENTIAL);
+
+	mapped_base = base;
+	mapped_length = length;
+	yy_scan_buffer(base, size + 2);
+	return true;
+}
+
+void unmap_input_file(void)
+{
+	if (mapped_base == NULL)
+		return;
+	yy_delete_buffer(YY_CURRENT_BUFFER);
+	munmap(mapped_base, mapped_length);
+	mapped_base = NULL;
+	mapped_length = 0;
+}
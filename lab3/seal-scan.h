@@ -0,0 +1,213 @@
+// -*-Mode: C++;-*-
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _SEAL_SCAN_H_
+#define _SEAL_SCAN_H_
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Fast paths for the scanner
+//
+//  Most of a Seal source is blanks, comment text and identifiers.  The
+//  flex rules take blanks and comment text one character per run of the
+//  DFA, and every identifier through the DFA for all the keywords; here
+//  an identifier is one run, looked up in a table of the keywords.
+//  scan_run<Class>(p, lines) instead skips the run of Class characters
+//  starting at p 16 bytes at a time with SSE2 (a byte at a time where
+//  SSE2 is not available), adds the newlines it skipped to lines, and
+//  returns the first character not in Class.
+//
+//  p points into the scanner's buffer, which ends with NULs; NUL is in
+//  no Class, so a run never goes past the buffer.  The loads are 16-byte
+//  aligned and so never reach into a page after the buffer.
+//
+//  The Makefile builds without optimization, which makes the intrinsics
+//  slower than the DFA; these functions are optimized regardless.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <string.h>
+#include "seal-parse.h"
+
+#if defined(__GNUC__) && !defined(__OPTIMIZE__)
+#pragma GCC push_options
+#pragma GCC optimize ("O2")
+#define SEAL_SCAN_OPTIMIZED
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+// Bit i is set if byte i of v is c.
+static inline unsigned scan_bytes_eq(__m128i v, char c)
+{
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+}
+
+// Bit i is set if byte i of v is between lo and hi.
+static inline unsigned scan_bytes_in(__m128i v, unsigned char lo, unsigned char hi)
+{
+  __m128i d = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(hi - lo)), d));
+}
+#endif
+
+// Blanks and newlines.
+struct ScanBlank
+{
+#ifdef __SSE2__
+  static unsigned block(__m128i v) { return scan_bytes_eq(v, ' ') | scan_bytes_in(v, '\t', '\r'); }
+#endif
+  static bool byte(unsigned char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+};
+
+// The text of a // comment, up to the newline ending it.
+struct ScanLineComment
+{
+#ifdef __SSE2__
+  static unsigned block(__m128i v) { return ~(scan_bytes_eq(v, '\n') | scan_bytes_eq(v, 0)); }
+#endif
+  static bool byte(unsigned char c) { return c != '\n' && c != 0; }
+};
+
+// The text of a /* comment, up to a '*' that may end it.
+struct ScanBlockComment
+{
+#ifdef __SSE2__
+  static unsigned block(__m128i v) { return ~(scan_bytes_eq(v, '*') | scan_bytes_eq(v, 0)); }
+#endif
+  static bool byte(unsigned char c) { return c != '*' && c != 0; }
+};
+
+// Letters, digits and underscores.
+struct ScanIdentifier
+{
+#ifdef __SSE2__
+  static unsigned block(__m128i v)
+  {
+    return scan_bytes_in(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z') |
+           scan_bytes_in(v, '0', '9') | scan_bytes_eq(v, '_');
+  }
+#endif
+  static bool byte(unsigned char c)
+  {
+    return ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || (c >= '0' && c <= '9') || c == '_';
+  }
+};
+
+template <class Class>
+static inline char *scan_run(char *p, int &lines)
+{
+#ifdef __SSE2__
+  char *block = (char *)((uintptr_t)p & ~(uintptr_t)15);
+  unsigned from = (0xFFFFu << (p - block)) & 0xFFFF;  // the bytes at or after p
+  for (;;) {
+    __m128i v = _mm_load_si128((const __m128i *)block);
+    unsigned stop = ~Class::block(v) & from;
+    unsigned newlines = scan_bytes_eq(v, '\n') & from;
+    if (stop) {
+      unsigned end = __builtin_ctz(stop);
+      lines += __builtin_popcount(newlines & ((1u << end) - 1));
+      return block + end;
+    }
+    lines += __builtin_popcount(newlines);
+    block += 16;
+    from = 0xFFFF;
+  }
+#else
+  for (; Class::byte(*p); p++)
+    lines += *p == '\n';
+  return p;
+#endif
+}
+
+//
+// The keywords and the type names.  scan_word(s, len) returns the one
+// the identifier s of length len spells, or NULL, with a single probe of
+// a perfect hash table built at compile time: scan_word_seed is the
+// first multiplier tried for which the hash of a word's first and last
+// characters and its length gives every word a slot of its own.
+//
+struct ScanWord
+{
+  const char *text;
+  int len;
+  int token;
+  int value;   // of a CONST_BOOL
+};
+
+static constexpr ScanWord scan_words[] = {
+  {"if", 2, IF, 0}, {"else", 4, ELSE, 0}, {"while", 5, WHILE, 0},
+  {"for", 3, FOR, 0}, {"break", 5, BREAK, 0}, {"continue", 8, CONTINUE, 0},
+  {"func", 4, FUNC, 0}, {"return", 6, RETURN, 0}, {"var", 3, VAR, 0},
+  {"true", 4, CONST_BOOL, 1}, {"false", 5, CONST_BOOL, 0},
+  {"Int", 3, TYPEID, 0}, {"Float", 5, TYPEID, 0}, {"String", 6, TYPEID, 0},
+  {"Bool", 4, TYPEID, 0}, {"Void", 4, TYPEID, 0}
+};
+
+#define SCAN_WORD_COUNT ((int)(sizeof(scan_words) / sizeof(scan_words[0])))
+#define SCAN_WORD_SLOTS 32     // the hash takes the top 5 bits
+#define SCAN_WORD_MAX_LEN 8
+
+static constexpr unsigned scan_word_hash(unsigned char first, unsigned char last, int len,
+                                         unsigned seed)
+{
+  return (((first << 8 | last) << 4 | len) * seed) >> 27;
+}
+
+static constexpr unsigned find_scan_word_seed()
+{
+  for (unsigned seed = 0x9E3779B1u; ; seed += 0x6A09E668u) {
+    bool used[SCAN_WORD_SLOTS] = {};
+    bool collision = false;
+    for (int i = 0; i < SCAN_WORD_COUNT; i++) {
+      const ScanWord &w = scan_words[i];
+      unsigned h = scan_word_hash(w.text[0], w.text[w.len - 1], w.len, seed);
+      collision = collision || used[h];
+      used[h] = true;
+    }
+    if (!collision)
+      return seed;
+  }
+}
+
+struct ScanWordTable
+{
+  signed char word[SCAN_WORD_SLOTS];   // index into scan_words, or -1
+};
+
+static constexpr ScanWordTable make_scan_word_table(unsigned seed)
+{
+  ScanWordTable table = {};
+  for (int h = 0; h < SCAN_WORD_SLOTS; h++)
+    table.word[h] = -1;
+  for (int i = 0; i < SCAN_WORD_COUNT; i++) {
+    const ScanWord &w = scan_words[i];
+    table.word[scan_word_hash(w.text[0], w.text[w.len - 1], w.len, seed)] = i;
+  }
+  return table;
+}
+
+static constexpr unsigned scan_word_seed = find_scan_word_seed();
+static constexpr ScanWordTable scan_word_table = make_scan_word_table(scan_word_seed);
+
+static inline const ScanWord *scan_word(const char *s, int len)
+{
+  if (len > SCAN_WORD_MAX_LEN)
+    return NULL;
+  int i = scan_word_table.word[scan_word_hash(s[0], s[len - 1], len, scan_word_seed)];
+  if (i < 0 || scan_words[i].len != len || memcmp(scan_words[i].text, s, len) != 0)
+    return NULL;
+  return &scan_words[i];
+}
+
+#ifdef SEAL_SCAN_OPTIMIZED
+#pragma GCC pop_options
+#undef SEAL_SCAN_OPTIMIZED
+#endif
+
+#endif
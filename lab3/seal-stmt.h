@@ -6,6 +6,9 @@
 #include "seal-tree.handcode.h"
 #include "seal-decl.h"
 
+class CheckCache; // see semant.h
+class CallGraph;  // see callgraph.h
+
 class Program_class : public tree_node
 {
 protected:
@@ -14,6 +17,7 @@ protected:
 public:
 	Program_class(Decls a1)
 	{
+		kind = NODE_PROGRAM;
 		decls = a1;
 	}
 	Program copy_Program();
@@ -21,8 +25,9 @@ public:
 	void dump(ostream &stream, int n);
 	void dump_with_types(ostream &, int);
 
-	void semant();
-	// for semantic analysis
+	// for semantic analysis; reports to errors and returns the number of
+	// errors found.  Functions found in cache are not checked again.
+	int semant(ostream &errors = cerr, CheckCache *cache = NULL, CallGraph *graph = NULL);
 };
 
 class Stmt_class : public tree_node
@@ -33,7 +38,7 @@ public:
 	virtual void dump_with_types(ostream &, int) = 0;
 	virtual void dump(ostream &, int) = 0;
 	virtual void check(Symbol) = 0;
-	virtual bool isReturnStmt() { return false; }
+	bool isReturnStmt() { return kind == NODE_RETURN; }
 };
 
 class StmtBlock_class : public Stmt_class
@@ -45,6 +50,7 @@ protected:
 public:
 	StmtBlock_class(VariableDecls a1, Stmts a2)
 	{
+		kind = NODE_STMT_BLOCK;
 		vars = a1;
 		stmts = a2;
 	}
@@ -67,6 +73,7 @@ protected:
 public:
 	IfStmt_class(Expr a1, StmtBlock a2, StmtBlock a3)
 	{
+		kind = NODE_IF;
 		condition = a1;
 		thenexpr = a2;
 		elseexpr = a3;
@@ -91,6 +98,7 @@ protected:
 public:
 	WhileStmt_class(Expr a1, StmtBlock a2)
 	{
+		kind = NODE_WHILE;
 		condition = a1;
 		body = a2;
 	}
@@ -111,6 +119,7 @@ protected:
 public:
 	ForStmt_class(Expr a1, Expr a2, Expr a3, StmtBlock a4)
 	{
+		kind = NODE_FOR;
 		initexpr = a1;
 		condition = a2;
 		loopact = a3;
@@ -134,6 +143,7 @@ protected:
 public:
 	ReturnStmt_class(Expr a2)
 	{
+		kind = NODE_RETURN;
 		value = a2;
 	}
 	Expr getValue() { return value; }
@@ -141,13 +151,15 @@ public:
 	void check(Symbol);
 	void dump_with_types(ostream &, int);
 	void dump(ostream &stream, int n);
-	bool isReturnStmt() { return true; }
 };
 
 class ContinueStmt_class : public Stmt_class
 {
 public:
-	ContinueStmt_class() {}
+	ContinueStmt_class()
+	{
+		kind = NODE_CONTINUE;
+	}
 	Stmt copy_Stmt();
 	void check(Symbol);
 	void dump_with_types(ostream &, int);
@@ -157,7 +169,10 @@ public:
 class BreakStmt_class : public Stmt_class
 {
 public:
-	BreakStmt_class() {}
+	BreakStmt_class()
+	{
+		kind = NODE_BREAK;
+	}
 	Stmt copy_Stmt();
 	void check(Symbol);
 	void dump_with_types(ostream &, int);
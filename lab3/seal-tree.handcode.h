@@ -9,7 +9,7 @@
 #include "seal.h"
 #include "stringtab.h"
 #define yylineno curr_lineno;
-extern int yylineno;
+extern thread_local int yylineno;
 
 inline Boolean copy_Boolean(Boolean b) { return b; }
 inline void assert_Boolean(Boolean) {}
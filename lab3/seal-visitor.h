@@ -0,0 +1,199 @@
+#ifndef _H_seal_visitor
+#define _H_seal_visitor
+
+//
+// SealVisitor<Derived, Result> dispatches on tree_node::get_kind() with one
+// switch and calls the handler of Derived for the concrete node class, e.g.
+//
+//    Result visitAdd(Add_class *);
+//
+// Handlers are found at compile time (CRTP), so they are ordinary member
+// calls that the compiler can inline.  A handler that Derived does not
+// define falls back to visitNode(tree_node *), which returns Result().
+// Handlers decide themselves which children to visit and in what order.
+//
+
+#include "tree.h"
+#include "seal-decl.h"
+#include "seal-stmt.h"
+#include "seal-expr.h"
+
+template <class Derived, class Result>
+class SealVisitor
+{
+public:
+   Result visit(tree_node *node)
+   {
+      Derived *self = static_cast<Derived *>(this);
+      switch (node->get_kind())
+      {
+      case NODE_PROGRAM:
+         return self->visitProgram(static_cast<Program_class *>(node));
+      case NODE_VARIABLE:
+         return self->visitVariable(static_cast<Variable_class *>(node));
+      case NODE_VARIABLE_DECL:
+         return self->visitVariableDecl(static_cast<VariableDecl_class *>(node));
+      case NODE_CALL_DECL:
+         return self->visitCallDecl(static_cast<CallDecl_class *>(node));
+      case NODE_STMT_BLOCK:
+         return self->visitStmtBlock(static_cast<StmtBlock_class *>(node));
+      case NODE_IF:
+         return self->visitIfStmt(static_cast<IfStmt_class *>(node));
+      case NODE_WHILE:
+         return self->visitWhileStmt(static_cast<WhileStmt_class *>(node));
+      case NODE_FOR:
+         return self->visitForStmt(static_cast<ForStmt_class *>(node));
+      case NODE_RETURN:
+         return self->visitReturnStmt(static_cast<ReturnStmt_class *>(node));
+      case NODE_CONTINUE:
+         return self->visitContinueStmt(static_cast<ContinueStmt_class *>(node));
+      case NODE_BREAK:
+         return self->visitBreakStmt(static_cast<BreakStmt_class *>(node));
+      case NODE_CALL:
+         return self->visitCall(static_cast<Call_class *>(node));
+      case NODE_ACTUAL:
+         return self->visitActual(static_cast<Actual_class *>(node));
+      case NODE_ASSIGN:
+         return self->visitAssign(static_cast<Assign_class *>(node));
+      case NODE_ADD:
+         return self->visitAdd(static_cast<Add_class *>(node));
+      case NODE_MINUS:
+         return self->visitMinus(static_cast<Minus_class *>(node));
+      case NODE_MULTI:
+         return self->visitMulti(static_cast<Multi_class *>(node));
+      case NODE_DIVIDE:
+         return self->visitDivide(static_cast<Divide_class *>(node));
+      case NODE_MOD:
+         return self->visitMod(static_cast<Mod_class *>(node));
+      case NODE_NEG:
+         return self->visitNeg(static_cast<Neg_class *>(node));
+      case NODE_LT:
+         return self->visitLt(static_cast<Lt_class *>(node));
+      case NODE_LE:
+         return self->visitLe(static_cast<Le_class *>(node));
+      case NODE_EQU:
+         return self->visitEqu(static_cast<Equ_class *>(node));
+      case NODE_NEQ:
+         return self->visitNeq(static_cast<Neq_class *>(node));
+      case NODE_GE:
+         return self->visitGe(static_cast<Ge_class *>(node));
+      case NODE_GT:
+         return self->visitGt(static_cast<Gt_class *>(node));
+      case NODE_AND:
+         return self->visitAnd(static_cast<And_class *>(node));
+      case NODE_OR:
+         return self->visitOr(static_cast<Or_class *>(node));
+      case NODE_XOR:
+         return self->visitXor(static_cast<Xor_class *>(node));
+      case NODE_NOT:
+         return self->visitNot(static_cast<Not_class *>(node));
+      case NODE_BITNOT:
+         return self->visitBitnot(static_cast<Bitnot_class *>(node));
+      case NODE_BITAND:
+         return self->visitBitand(static_cast<Bitand_class *>(node));
+      case NODE_BITOR:
+         return self->visitBitor(static_cast<Bitor_class *>(node));
+      case NODE_CONST_INT:
+         return self->visitConst_int(static_cast<Const_int_class *>(node));
+      case NODE_CONST_STRING:
+         return self->visitConst_string(static_cast<Const_string_class *>(node));
+      case NODE_CONST_FLOAT:
+         return self->visitConst_float(static_cast<Const_float_class *>(node));
+      case NODE_CONST_BOOL:
+         return self->visitConst_bool(static_cast<Const_bool_class *>(node));
+      case NODE_OBJECT:
+         return self->visitObject(static_cast<Object_class *>(node));
+      case NODE_NO_EXPR:
+         return self->visitNo_expr(static_cast<No_expr_class *>(node));
+      default:
+         return self->visitNode(node);
+      }
+   }
+
+   Result visitNode(tree_node *) { return Result(); }
+
+   Result visitProgram(Program_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitVariable(Variable_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitVariableDecl(VariableDecl_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitCallDecl(CallDecl_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitStmtBlock(StmtBlock_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitIfStmt(IfStmt_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitWhileStmt(WhileStmt_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitForStmt(ForStmt_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitReturnStmt(ReturnStmt_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitContinueStmt(ContinueStmt_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitBreakStmt(BreakStmt_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitCall(Call_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitActual(Actual_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitAssign(Assign_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitAdd(Add_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitMinus(Minus_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitMulti(Multi_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitDivide(Divide_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitMod(Mod_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitNeg(Neg_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitLt(Lt_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitLe(Le_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitEqu(Equ_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitNeq(Neq_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitGe(Ge_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitGt(Gt_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitAnd(And_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitOr(Or_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitXor(Xor_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitNot(Not_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitBitnot(Bitnot_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitBitand(Bitand_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitBitor(Bitor_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitConst_int(Const_int_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitConst_string(Const_string_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitConst_float(Const_float_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitConst_bool(Const_bool_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitObject(Object_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+   Result visitNo_expr(No_expr_class *node) { return static_cast<Derived *>(this)->visitNode(node); }
+};
+
+//
+// ExprChild finds the n-th subexpression of an expression, in the order
+// the subexpressions appear in the source, or NULL if it has fewer than
+// n+1; see Expr_class::getChild.  The arguments of a call are its Actual
+// nodes.
+//
+class ExprChild : public SealVisitor<ExprChild, Expr>
+{
+private:
+   int n;
+
+   template <class Unary>
+   Expr operand(Unary *e) { return n == 0 ? e->getOperand() : NULL; }
+   template <class Binary>
+   Expr operands(Binary *e) { return n == 0 ? e->getLeft() : n == 1 ? e->getRight() : NULL; }
+
+public:
+   ExprChild(int child) : n(child) {}
+
+   Expr visitCall(Call_class *e) { return n < e->getActuals()->len() ? e->getActuals()->nth(n) : NULL; }
+   Expr visitActual(Actual_class *e) { return n == 0 ? e->getExpr() : NULL; }
+   Expr visitAssign(Assign_class *e) { return n == 0 ? e->getValue() : NULL; }
+   Expr visitNeg(Neg_class *e) { return operand(e); }
+   Expr visitNot(Not_class *e) { return operand(e); }
+   Expr visitBitnot(Bitnot_class *e) { return operand(e); }
+   Expr visitAdd(Add_class *e) { return operands(e); }
+   Expr visitMinus(Minus_class *e) { return operands(e); }
+   Expr visitMulti(Multi_class *e) { return operands(e); }
+   Expr visitDivide(Divide_class *e) { return operands(e); }
+   Expr visitMod(Mod_class *e) { return operands(e); }
+   Expr visitLt(Lt_class *e) { return operands(e); }
+   Expr visitLe(Le_class *e) { return operands(e); }
+   Expr visitEqu(Equ_class *e) { return operands(e); }
+   Expr visitNeq(Neq_class *e) { return operands(e); }
+   Expr visitGe(Ge_class *e) { return operands(e); }
+   Expr visitGt(Gt_class *e) { return operands(e); }
+   Expr visitAnd(And_class *e) { return operands(e); }
+   Expr visitOr(Or_class *e) { return operands(e); }
+   Expr visitXor(Xor_class *e) { return operands(e); }
+   Expr visitBitand(Bitand_class *e) { return operands(e); }
+   Expr visitBitor(Bitor_class *e) { return operands(e); }
+};
+
+#endif
@@ -1,33 +1,276 @@
 #include <stdio.h>
 #include <unistd.h>    // for getopt
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
 #include "seal-decl.h"
 #include "seal-expr.h"
 #include "seal-stmt.h"
+#include "callgraph.h"
+#include "cfg.h"
+#include "token-pipe.h"
+#include "token-stream.h"
+#include "utilities.h"
 
-extern Program ast_root;      // root of the abstract syntax tree
-FILE *fin;                    // input file
+extern thread_local Program ast_root; // root of the abstract syntax tree
+thread_local FILE *fin;               // input file
 extern int optind;  // used for option processing (man 3 getopt for more info)
 extern int seal_yyparse(void); // entry point to the AST parser
-extern int omerrs;            // syntax check errors
-char *curr_filename = "<stdin>";
+extern int seal_yylex(void);   // the scanner, for -L
+extern int yylex_destroy(void); // resets the lexer for the next input file
+extern bool map_input_file(const char *filename); // scan the file in place
+extern void unmap_input_file(void);
+extern thread_local int omerrs;       // syntax check errors
+thread_local char *curr_filename = "<stdin>";
+extern char *manifest_filename;       // -m: file listing the input files
+extern char *server_socket;           // -S: socket of the compile server
+extern char *token_filename;          // -w: write the input's tokens there
+extern int lex_benchmark;             // -L: time the scanner only
+extern int lex_fast_scan;             // whether the scanner uses seal-scan.h
+extern int lex_pipeline;              // -x: lex on a thread of its own
+extern int semant_debug;              // -s: also print the call graph and CFGs
+extern int semant_jobs;               // -j: threads checking function bodies
 
 void handle_flags(int argc, char *argv[]);
+int run_server(char *socket_path);
 
-int main(int argc, char *argv[]) {
-  fin = fopen(argv[optind], "r");
-	    if (fin == NULL) {
-		cerr << "Could not open input file " << argv[optind] << endl;
-		exit(1);
-	}
+//
+// Batch mode.  Given several input files, or a manifest (-m) naming one
+// file per line, every file is lexed, parsed and checked in this one
+// process.  Instead of the typed AST, one line per file tells whether it
+// passed, and a last line gives the totals and the throughput.
+//
+// Between files the lexer is reset, and the string tables and the arenas
+// holding the strings and the AST are emptied but keep their memory, so
+// later files mostly reuse what earlier ones allocated.
+//
+
+// Empty the string tables; every Symbol becomes invalid.
+void reset_string_tables()
+{
+  idtable.clear();
+  inttable.clear();
+  stringtable.clear();
+  floattable.clear();
+  stringtab_arena.reset();
+}
+
+// Forget the last input and its AST; the string tables are kept.
+void reset_parse_state()
+{
+  yylex_destroy();
+  ast_root = NULL;
+  omerrs = 0;
+  tree_arena.reset();
+}
+
+// Parse filename into ast_root: a token stream (-w) without lexing,
+// anything else through the lexer, on a thread of its own with -x.
+// Returns false if the file cannot be read.  fin is left open for the
+// caller to close.
+static bool parse_file(char *filename)
+{
+  fin = NULL;
+  if (is_token_stream(filename))
+    return parse_token_stream(filename);
+  if (lex_pipeline)
+    return parse_pipelined(filename);
+  if (!map_input_file(filename) && (fin = fopen(filename, "r")) == NULL)
+    return false;
+  seal_yyparse();
+  unmap_input_file();
+  return true;
+}
+
+// Compile one file of a batch and print its result line.  Returns
+// whether the file has no errors; lines counts the lines read.  A fatal
+// lexer error, or too many syntax errors, jumps back here through
+// input_error_jump and fails only this file.
+static bool compile_in_batch(char *filename, long &lines)
+{
+  jmp_buf input_error;
+  curr_filename = filename;
   curr_lineno = 1;
+  input_error_jump = &input_error;
+  if (setjmp(input_error) != 0) {
+    input_error_jump = NULL;
+    unmap_input_file();
+    if (fin != NULL)
+      fclose(fin);
+    lines += curr_lineno - 1;
+    cout << filename << (omerrs > 50 ? ": syntax errors" : ": lexical errors") << endl;
+    reset_parse_state();
+    reset_string_tables();
+    return false;
+  }
+  bool parsed = parse_file(filename);
+  input_error_jump = NULL;
+  if (!parsed) {
+    cout << filename << ": could not open input file" << endl;
+    return false;
+  }
+  lines += curr_lineno - 1;
+
+  bool ok = false;
+  if (omerrs != 0 || ast_root == NULL) {
+    cout << filename << ": syntax errors" << endl;
+  } else {
+    int errors = ast_root->semant();
+    if (errors > 0)
+      cout << filename << ": " << errors << " semantic errors" << endl;
+    else
+      cout << filename << ": ok" << endl;
+    ok = errors == 0;
+  }
+  if (fin != NULL)
+    fclose(fin);
+  reset_parse_state();
+  reset_string_tables();
+  return ok;
+}
+
+static int run_batch(std::vector<std::string> &files)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int failed = 0;
+  long lines = 0;
+  for (std::string &file : files) {
+    if (!compile_in_batch(&file[0], lines))
+      failed++;
+  }
+  tree_arena.release();
+  stringtab_arena.release();
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (seconds <= 0)
+    seconds = 1e-9;
+  cout << files.size() << " files, " << failed << " failed, " << lines << " lines in "
+       << std::fixed << std::setprecision(3) << seconds << " s ("
+       << std::setprecision(0) << files.size() / seconds << " files/s, "
+       << lines / seconds << " lines/s)" << endl;
+  return failed == 0 ? 0 : 1;
+}
+
+//
+// Scanner benchmark (-L).  Every input file is scanned twice, by the flex
+// rules alone and with the fast paths of seal-scan.h, and the throughput
+// of both is printed.  Nothing is parsed.
+//
+
+// Scan filename once; returns the seconds taken, or -1 if it cannot be
+// opened.
+static double time_scan(char *filename, long &tokens)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  fin = NULL;
+  if (!map_input_file(filename) && (fin = fopen(filename, "r")) == NULL)
+    return -1;
+  curr_filename = filename;
+  curr_lineno = 1;
+  tokens = 0;
+  while (seal_yylex() != 0)
+    tokens++;
+  unmap_input_file();
+  if (fin != NULL)
+    fclose(fin);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  reset_parse_state();
+  reset_string_tables();
+  return seconds > 0 ? seconds : 1e-9;
+}
+
+static int run_lex_benchmark(std::vector<std::string> &files)
+{
+  for (std::string &file : files) {
+    std::ifstream in(file, std::ios::binary | std::ios::ate);
+    long tokens = 0, bytes = in ? (long)in.tellg() : 0;
+    lex_fast_scan = 0;
+    double flex = time_scan(&file[0], tokens);
+    lex_fast_scan = 1;
+    double fast = time_scan(&file[0], tokens);
+    if (flex < 0 || fast < 0) {
+      cout << file << ": could not open input file" << endl;
+      continue;
+    }
+    cout << file << ": " << tokens << " tokens, " << bytes << " bytes; "
+         << std::fixed << std::setprecision(1) << "flex " << bytes / flex / 1e6
+         << " MB/s, fast paths " << bytes / fast / 1e6 << " MB/s ("
+         << std::setprecision(2) << flex / fast << "x)" << endl;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
   handle_flags(argc,argv);
-  seal_yyparse();
+  bool many = server_socket != NULL || manifest_filename != NULL || argc - optind > 1;
+  // Programs come one after another in batch and server mode, mostly
+  // with few functions each; spreading each one's functions over threads
+  // costs more than it saves, so one thread checks them unless -j asks.
+  if (many && semant_jobs == 0)
+    semant_jobs = 1;
+  if (server_socket != NULL)
+    return run_server(server_socket);
+  if (token_filename != NULL) {
+    std::ofstream out(token_filename, std::ios::binary);
+    if (!out) {
+      cerr << "Could not open token stream " << token_filename << endl;
+      exit(1);
+    }
+    if (!write_token_stream(argv[optind], out)) {
+      cerr << "Could not open input file " << argv[optind] << endl;
+      exit(1);
+    }
+    return 0;
+  }
+  if (lex_benchmark || many) {
+    std::vector<std::string> files(argv + optind, argv + argc);
+    if (manifest_filename != NULL) {
+      std::ifstream manifest(manifest_filename);
+      if (!manifest) {
+        cerr << "Could not open manifest " << manifest_filename << endl;
+        exit(1);
+      }
+      std::string line;
+      while (std::getline(manifest, line))
+        if (!line.empty())
+          files.push_back(line);
+    }
+    if (lex_benchmark)
+      return run_lex_benchmark(files);
+    return run_batch(files);
+  }
+
+  curr_lineno = 1;
+  if (!parse_file(argv[optind])) {
+    cerr << "Could not open input file " << argv[optind] << endl;
+    exit(1);
+  }
   if(omerrs != 0 || ast_root == NULL){
     cout << "syntax analyze failed. Please make sure syntax parser passed." << endl;
     exit(-1);
   }
-  ast_root->semant();
+  CallGraph graph;
+  int errors = ast_root->semant(cerr, NULL, &graph);
+  if (semant_debug) {
+    graph.dump(cerr);
+    ControlFlowGraph cfg;
+    for (int f = 0; f < graph.size(); f++) {
+      if (!graph.function(f)->isReachable())
+        continue;
+      cfg.build(graph.function(f));
+      cerr << graph.function(f)->getName() << ":\n";
+      cfg.dump(cerr);
+    }
+  }
+  if (errors > 0) {
+    exit(1);
+  }
   ast_root->dump_with_types(cout,0);
-  fclose(fin);
+  tree_arena.release();        // frees the whole AST
+  ast_root = NULL;
+  if (fin != NULL)
+    fclose(fin);
 }
 
@@ -0,0 +1,196 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  semant-server.cc
+//
+//  The compile server (semant -S socket).  It listens on a Unix domain
+//  socket and checks one Seal program per connection:
+//
+//      the client writes the source and shuts down its writing side;
+//      the server answers with
+//
+//          status <s>\n
+//          diagnostics <n>\n<n bytes>
+//          ast <n>\n<n bytes>
+//
+//      and closes the connection.  s is 0 if the program is correct, 1
+//      if it has semantic errors and 2 if it could not be parsed.  The
+//      diagnostics are what semant writes to cerr; the ast is the typed
+//      AST dump, empty unless s is 0.
+//
+//  Requests are handled one at a time by the thread that runs the
+//  server.  The string tables, with the predefined symbols, stay filled
+//  from one request to the next, and the AST arena is rewound rather
+//  than freed, so a small program is checked without new allocations.
+//  The tables are emptied once they reach MAX_IDS identifiers.
+//
+//  Checking is incremental: the results of every function checked are
+//  kept in a CheckCache, so when an editor sends a file again only the
+//  functions that changed, or that use a name whose declaration
+//  changed, are checked.  The cache is emptied with the string tables,
+//  or once it holds MAX_CACHED_CALLS functions.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sstream>
+#include <string>
+#include "seal-decl.h"
+#include "seal-expr.h"
+#include "seal-stmt.h"
+#include "semant.h"
+#include "utilities.h"
+
+#define MAX_IDS 65536          // identifiers kept in idtable between requests
+#define MAX_CACHED_CALLS 65536 // function results kept between requests
+
+extern thread_local Program ast_root;
+extern thread_local FILE *fin;
+extern thread_local int omerrs;
+extern thread_local char *curr_filename;
+extern int seal_yyparse(void);
+
+void reset_string_tables();
+void reset_parse_state();
+
+static char *socket_path;
+static CheckCache check_cache;
+
+static void stop_server(int sig)
+{
+  unlink(socket_path);
+  _exit(0);
+}
+
+// Read from fd until the client shuts down its side of the connection.
+static bool read_request(int fd, std::string &source)
+{
+  char buf[4096];
+  for (;;) {
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n == 0)
+      return true;
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    source.append(buf, n);
+  }
+}
+
+static void write_all(int fd, const std::string &data)
+{
+  const char *p = data.data();
+  size_t left = data.size();
+  while (left > 0) {
+    ssize_t n = write(fd, p, left);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return;    // the client went away
+    }
+    p += n;
+    left -= n;
+  }
+}
+
+//
+// Check source and build the reply.  Parse errors and the lexer's fatal
+// errors go to cerr, so cerr is pointed at the diagnostics meanwhile; a
+// fatal error jumps back here through input_error_jump.
+//
+static std::string compile_request(std::string &source)
+{
+  std::ostringstream diagnostics, ast;
+  std::streambuf *saved = cerr.rdbuf(diagnostics.rdbuf());
+  jmp_buf input_error;
+  int status;
+
+  fin = fmemopen(&source[0], source.size(), "r");
+  curr_filename = "<request>";
+  curr_lineno = 1;
+  input_error_jump = &input_error;
+  if (setjmp(input_error) != 0) {
+    status = 2;
+  } else {
+    seal_yyparse();
+    if (omerrs != 0 || ast_root == NULL) {
+      status = 2;
+    } else if (ast_root->semant(diagnostics, &check_cache) > 0) {
+      status = 1;
+    } else {
+      ast_root->dump_with_types(ast, 0);
+      status = 0;
+    }
+  }
+  input_error_jump = NULL;
+  cerr.rdbuf(saved);
+  fclose(fin);
+
+  reset_parse_state();
+  if (idtable.size() > MAX_IDS) {
+    reset_string_tables();
+    check_cache.clear();
+  } else if (check_cache.size() > MAX_CACHED_CALLS) {
+    check_cache.clear();
+  }
+
+  std::ostringstream reply;
+  reply << "status " << status << "\n"
+        << "diagnostics " << diagnostics.str().size() << "\n" << diagnostics.str()
+        << "ast " << ast.str().size() << "\n" << ast.str();
+  return reply.str();
+}
+
+int run_server(char *path)
+{
+  struct sockaddr_un addr;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    cerr << "Socket path too long: " << path << endl;
+    return 1;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(path);
+  if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(listener, 16) < 0) {
+    cerr << "Could not listen on " << path << ": " << strerror(errno) << endl;
+    return 1;
+  }
+  socket_path = path;
+  signal(SIGINT, stop_server);
+  signal(SIGTERM, stop_server);
+  signal(SIGPIPE, SIG_IGN);
+
+  for (;;) {
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR)
+        continue;
+      cerr << "accept: " << strerror(errno) << endl;
+      break;
+    }
+    std::string source;
+    if (read_request(fd, source))
+      write_all(fd, compile_request(source));
+    close(fd);
+  }
+  close(listener);
+  unlink(path);
+  return 1;
+}
@@ -1,21 +1,105 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include "semant.h"
 #include "utilities.h"
 
 extern int semant_debug;
-extern char *curr_filename;
+extern int semant_jobs;
+extern int semant_prune;
+extern thread_local char *curr_filename;
 
-static ostream &error_stream = cerr;
-static int semant_errors = 0;
-static Decl curr_decl = 0;
+// What a name stands for: its type and its slot.
+struct ObjectInfo
+{
+    Symbol type;
+    SlotKind kind;
+    int slot;
+};
+
+typedef SymbolTable<Symbol, ObjectInfo> ObjectEnvironment; // name, info
+
+//
+// Everything one compilation's checking shares: the predefined symbols,
+// the global tables and the error count.  Program_class::semant makes
+// one per call, so programs may be checked one after another or on
+// different threads at once; the threads checking the function bodies
+// of one program share their program's context.
+//
+struct SemantContext
+{
+    // Where diagnostics go when no other error_stream is set.
+    ostream *errors;
+    std::atomic<int> errorCount;
+
+    // Predefined symbols, see initialize_constants.
+    Symbol Int, Float, String, Bool, Void, Main, print;
+
+    // TypeId of each idtable entry, indexed by the entry's index.
+    std::vector<unsigned char> typeIds;
+
+    // The type Symbol of each built-in TypeId.
+    Symbol typeSymbols[TYPE_COUNT];
+
+    // Global variables.  The table is filled before any function body is
+    // checked and only read afterwards, so all threads can share it.
+    ObjectEnvironment objectEnv;
+
+    std::map<Symbol, CallDecl> callMap;
+
+    // Every function, in declaration order.  The name of a function is
+    // visible in its own body and in the bodies of the functions declared
+    // after it; it hides a global of the same name.
+    std::vector<ObjectInfo> callInfos;
+    std::map<Symbol, std::vector<int> > callsByName;
+
+    // What each global name stands for, for incremental checking; indexed
+    // by idtable index.  See initialize_name_meanings.
+    std::vector<unsigned long long> nameMeanings;
+
+    SemantContext(ostream &s) : errors(&s), errorCount(0) {}
+};
 
-typedef SymbolTable<Symbol, Symbol> ObjectEnvironment; // name, type
-ObjectEnvironment objectEnv;
+// The context of the program a thread is checking.
+static thread_local SemantContext *context = NULL;
 
-unsigned int isInLoop = 0;
-std::map<Symbol, CallDecl> callMap;
+// Function bodies may be checked on several threads.  Each thread
+// writes its diagnostics to its own error_stream, see check_calls.
+static thread_local ostream *error_stream = NULL;
+
+// Parameters and locals of the function a thread is checking.
+static thread_local ObjectEnvironment localEnv;
+static thread_local int currentCall = 0;
+
+// Locals of the function being checked.  A block's locals take the
+// slots after those of the enclosing blocks, and sibling blocks reuse
+// the same slots, so maxLocalSlots is the deepest nesting of locals.
+static thread_local int localSlots = 0;
+static thread_local int maxLocalSlots = 0;
+
+static thread_local unsigned int isInLoop = 0;
+
+// Errors reported by this thread for the function it is checking.
+static thread_local int callErrors = 0;
+
+// Where each diagnostic of the function being checked for the cache
+// starts in error_stream, after its line, and that line; see check_call.
+struct DiagnosticMark
+{
+    int line;
+    std::streamoff start;
+};
+static thread_local std::vector<DiagnosticMark> *diagnosticMarks = NULL;
+
+// The names of the functions called by the function a thread is
+// checking, one per Call that resolves to a function; see check_calls.
+static thread_local std::vector<Symbol> *calledNames = NULL;
 
 ///////////////////////////////////////////////
 // helper func
@@ -23,20 +107,25 @@ std::map<Symbol, CallDecl> callMap;
 
 static ostream &semant_error()
 {
-    semant_errors++;
-    return error_stream;
+    context->errorCount++;
+    callErrors++;
+    return *error_stream;
 }
 
 static ostream &semant_error(tree_node *t)
 {
-    error_stream << t->get_line_number() << ": ";
+    *error_stream << t->get_line_number() << ": ";
+    if (diagnosticMarks)
+    {
+        diagnosticMarks->push_back(DiagnosticMark{t->get_line_number(), error_stream->tellp()});
+    }
     return semant_error();
 }
 
 static ostream &internal_error(int lineno)
 {
-    error_stream << "FATAL:" << lineno << ": ";
-    return error_stream;
+    *error_stream << "FATAL:" << lineno << ": ";
+    return *error_stream;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -49,23 +138,14 @@ static ostream &internal_error(int lineno)
 //
 //////////////////////////////////////////////////////////////////////
 
-static Symbol
-    Int,
-    Float,
-    String,
-    Bool,
-    Void,
-    Main,
-    print;
-
 bool isValidCallName(Symbol type)
 {
-    return type != (Symbol)print;
+    return type != (Symbol)context->print;
 }
 
 bool isValidTypeName(Symbol type)
 {
-    return type != Void;
+    return type != context->Void;
 }
 
 //
@@ -75,16 +155,36 @@ bool isValidTypeName(Symbol type)
 static void initialize_constants(void)
 {
     // 4 basic types and Void type
-    Bool = idtable.add_string("Bool");
-    Int = idtable.add_string("Int");
-    String = idtable.add_string("String");
-    Float = idtable.add_string("Float");
-    Void = idtable.add_string("Void");
+    context->Bool = idtable.add_string("Bool");
+    context->Int = idtable.add_string("Int");
+    context->String = idtable.add_string("String");
+    context->Float = idtable.add_string("Float");
+    context->Void = idtable.add_string("Void");
     // Main function
-    Main = idtable.add_string("main");
+    context->Main = idtable.add_string("main");
 
     // classical function to print things, so defined here for call.
-    print = idtable.add_string("printf");
+    context->print = idtable.add_string("printf");
+}
+
+//
+// Build typeIds once every identifier of the program has been interned.
+//
+
+static void initialize_type_ids(void)
+{
+    context->typeIds.assign(idtable.size(), TYPE_OTHER);
+    context->typeIds[context->Int->get_index()] = TYPE_INT;
+    context->typeIds[context->Float->get_index()] = TYPE_FLOAT;
+    context->typeIds[context->String->get_index()] = TYPE_STRING;
+    context->typeIds[context->Bool->get_index()] = TYPE_BOOL;
+    context->typeIds[context->Void->get_index()] = TYPE_VOID;
+
+    context->typeSymbols[TYPE_INT] = context->Int;
+    context->typeSymbols[TYPE_FLOAT] = context->Float;
+    context->typeSymbols[TYPE_STRING] = context->String;
+    context->typeSymbols[TYPE_BOOL] = context->Bool;
+    context->typeSymbols[TYPE_VOID] = context->Void;
 }
 
 /*
@@ -94,16 +194,135 @@ static void initialize_constants(void)
     Of course, you can add any other functions to help.
 */
 
+// Every type name is interned in idtable, so two types are the same
+// exactly when their Symbols are the same pointer.
 static bool sameType(Symbol name1, Symbol name2)
 {
-    return strcmp(name1->get_string(), name2->get_string()) == 0;
+    return name1 == name2;
+}
+
+// TypeId of a type Symbol; one load from typeIds.  Symbols interned
+// after initialize_type_ids (and NULL) are never built-in types.
+static TypeId typeId(Symbol type)
+{
+    if (type == NULL || type->get_index() >= (int)context->typeIds.size())
+    {
+        return TYPE_OTHER;
+    }
+    return (TypeId)context->typeIds[type->get_index()];
+}
+
+//
+// Operator typing.
+//
+// The result type of every operator is read from operatorTable, indexed by
+// (operator, left operand type, right operand type).  The table is computed
+// at compile time from operatorResult, which states the typing rule of each
+// operator; unary operators ignore the right operand.  A result of
+// TYPE_VOID marks an ill-typed use, for which the node gets type Void and
+// the operator's message in operatorErrors is reported.
+//
+
+static constexpr bool isNumeric(int type)
+{
+    return type == TYPE_INT || type == TYPE_FLOAT;
+}
+
+static constexpr TypeId operatorResult(int op, int left, int right)
+{
+    switch (op)
+    {
+    case OP_ADD:
+    case OP_MINUS:
+    case OP_MULTI:
+    case OP_DIVIDE:
+        if (left == TYPE_INT && right == TYPE_INT)
+            return TYPE_INT;
+        return isNumeric(left) && isNumeric(right) ? TYPE_FLOAT : TYPE_VOID;
+    case OP_MOD:
+    case OP_BITAND:
+    case OP_BITOR:
+        return left == TYPE_INT && right == TYPE_INT ? TYPE_INT : TYPE_VOID;
+    case OP_NEG:
+        return isNumeric(left) ? (TypeId)left : TYPE_VOID;
+    case OP_LT:
+    case OP_LE:
+    case OP_EQU:
+    case OP_GE:
+    case OP_GT:
+        return isNumeric(left) && isNumeric(right) ? TYPE_BOOL : TYPE_VOID;
+    case OP_NEQ:
+        if (left == TYPE_BOOL && right == TYPE_BOOL)
+            return TYPE_BOOL;
+        return isNumeric(left) && isNumeric(right) ? TYPE_BOOL : TYPE_VOID;
+    case OP_AND:
+    case OP_OR:
+    case OP_XOR:
+        return left == TYPE_BOOL && right == TYPE_BOOL ? TYPE_BOOL : TYPE_VOID;
+    case OP_NOT:
+        return left == TYPE_BOOL ? TYPE_BOOL : TYPE_VOID;
+    case OP_BITNOT:
+        return left == TYPE_INT ? TYPE_INT : TYPE_VOID;
+    }
+    return TYPE_VOID;
+}
+
+struct OperatorTable
+{
+    unsigned char result[OP_COUNT][TYPE_COUNT][TYPE_COUNT];
+
+    constexpr OperatorTable() : result()
+    {
+        for (int op = 0; op < OP_COUNT; ++op)
+            for (int left = 0; left < TYPE_COUNT; ++left)
+                for (int right = 0; right < TYPE_COUNT; ++right)
+                    result[op][left][right] = operatorResult(op, left, right);
+    }
+};
+
+static constexpr OperatorTable operatorTable;
+
+static const char *const operatorErrors[OP_COUNT] = {
+    "The types of two values of this addition expression are wrong.\n",
+    "The types of two values of this substraction expression are wrong.\n",
+    "The types of two values of this multiplication expression are wrong.\n",
+    "The types of two values of this division expression are wrong.\n",
+    "The types of two values of this mod expression are wrong.\n",
+    "The type of the value in this negative expression is wrong.\n",
+    "The types of two values of this lt expression are wrong.\n",
+    "The types of two values of this le expression are wrong.\n",
+    "The types of two values of this equ expression are wrong.\n",
+    "The types of two values of this neq expression are wrong.\n",
+    "The types of two values of this ge expression are wrong.\n",
+    "The types of two values of this gt expression are wrong.\n",
+    "The types of two values of this and expression are wrong.\n",
+    "The types of two values of this or expression are wrong.\n",
+    "The types of two values of this xor expression are wrong.\n",
+    "The types of two values of this not expression are wrong.\n",
+    "The types of two values of this bitand expression are wrong.\n",
+    "The types of two values of this bitor expression are wrong.\n",
+    "The types of two values of this bitnot expression are wrong.\n",
+};
+
+static Symbol checkOperator(Expr expr, Operator op, Symbol left, Symbol right)
+{
+    TypeId result = (TypeId)operatorTable.result[op][typeId(left)][typeId(right)];
+    if (result == TYPE_VOID)
+    {
+        expr->setType(context->Void);
+        semant_error(expr) << operatorErrors[op];
+    }
+    else
+    {
+        expr->setType(context->typeSymbols[result]);
+    }
+    return expr->getType();
 }
 
 static void install_calls(Decls decls)
 {
-    for (int i = decls->first(); decls->more(i); i = decls->next(i))
+    for (Decl decl : *decls)
     {
-        Decl decl = decls->nth(i);
         if (decl->isCallDecl())
         {
             Symbol name = decl->getName();
@@ -112,17 +331,17 @@ static void install_calls(Decls decls)
             {
                 semant_error(decl) << "The name of function isn't valid.\n";
             }
-            else if (name == Main)
+            else if (name == context->Main)
             {
-                callMap.insert(std::make_pair(name, CallDecl(decl)));
+                context->callMap.insert(std::make_pair(name, CallDecl(decl)));
             }
-            else if (callMap.find(name) != callMap.end())
+            else if (context->callMap.find(name) != context->callMap.end())
             {
                 semant_error(decl) << "This function has already been defined.\n";
             }
             else
             {
-                callMap.insert(std::make_pair(name, CallDecl(decl)));
+                context->callMap.insert(std::make_pair(name, CallDecl(decl)));
             }
         }
     }
@@ -130,9 +349,9 @@ static void install_calls(Decls decls)
 
 static void install_globalVars(Decls decls)
 {
-    for (int i = decls->first(); decls->more(i); i = decls->next(i))
+    int globalSlots = 0;
+    for (Decl decl : *decls)
     {
-        Decl decl = decls->nth(i);
         if (!decl->isCallDecl())
         {
             Symbol name = decl->getName();
@@ -141,7 +360,7 @@ static void install_globalVars(Decls decls)
             {
                 semant_error(decl) << "The name of variable isn't valid.\n";
             }
-            else if (objectEnv.lookup(name) != NULL)
+            else if (context->objectEnv.lookup(name) != NULL)
             {
                 semant_error(decl) << "This variable has already been define.\n";
             }
@@ -151,646 +370,1135 @@ static void install_globalVars(Decls decls)
             }
             else
             {
-                objectEnv.addid(name, new Symbol(type));
+                context->objectEnv.addid(name, ObjectInfo{type, SLOT_GLOBAL, globalSlots++});
             }
         }
     }
 }
 
-static void check_calls(Decls decls)
+// What a name stands for outside the function being checked: a
+// function visible from it, else a global variable.
+static ObjectInfo *lookupGlobal(Symbol name)
 {
-    for (int i = decls->first(); decls->more(i); i = decls->next(i))
+    std::map<Symbol, std::vector<int> >::iterator it = context->callsByName.find(name);
+    if (it != context->callsByName.end())
     {
-        Decl decl = decls->nth(i);
-        if (decl->isCallDecl())
+        std::vector<int> &calls = it->second;
+        std::vector<int>::iterator last = std::upper_bound(calls.begin(), calls.end(), currentCall);
+        if (last != calls.begin())
         {
-            objectEnv.addid(decl->getName(), new Symbol(decl->getType()));
-            decl->check();
+            return &context->callInfos[*(last - 1)];
         }
     }
+    return context->objectEnv.lookup(name);
 }
 
-static void check_main()
+// The innermost declaration of a name inside the function being checked.
+static ObjectInfo *lookupObject(Symbol name)
 {
-    std::map<Symbol, CallDecl>::iterator it = callMap.find(Main);
-    if (it == callMap.end())
+    ObjectInfo *info = localEnv.lookup(name);
+    if (info)
     {
-        semant_error() << "The main function doesn't exsits.\n";
+        return info;
     }
-    else
+    return lookupGlobal(name);
+}
+
+//
+// Incremental checking.
+//
+// With a CheckCache, each function body is fingerprinted before it is
+// checked.  The fingerprint covers the function's tree with its names,
+// types and line numbers, the latter counted from the function's line so
+// that editing one function leaves the keys of those after it alone,
+// and, for every name the function uses, what the name stands for
+// outside the function: the function or global variable lookupGlobal
+// finds and the signature of the function a call of that name would
+// reach.  Those are all the inputs of checking a body, so a function
+// whose fingerprint is in the cache gets the recorded types, slots and
+// diagnostics instead of being checked again.  Constant values are left
+// out, since no check looks at them.
+//
+
+// Calls visit on every node of call, parents before children and the
+// children in source order.  Like checkType, the walk keeps its own
+// stack, so deep expressions do not exhaust the call stack; children
+// are pushed last first.
+template <class Visit>
+static void walkCall(CallDecl call, Visit visit)
+{
+    static thread_local std::vector<tree_node *> work;
+    work.assign(1, call);
+    while (!work.empty())
     {
-        CallDecl mainDecl = it->second;
-        if (!sameType(mainDecl->getType(), Void))
+        tree_node *node = work.back();
+        work.pop_back();
+        visit(node);
+
+        switch (node->get_kind())
         {
-            semant_error(mainDecl) << "Main function should have return type Void.\n";
+        case NODE_CALL_DECL:
+        {
+            CallDecl decl = static_cast<CallDecl>(node);
+            work.push_back(decl->getBody());
+            for (int i = decl->getVariables()->len() - 1; i >= 0; --i)
+            {
+                work.push_back(decl->getVariables()->nth(i));
+            }
+            break;
         }
-        if (mainDecl->getVariables()->len() > 0)
+        case NODE_VARIABLE_DECL:
+            // its Variable holds nothing the walk needs
+            break;
+        case NODE_STMT_BLOCK:
         {
-            semant_error(mainDecl) << "The main function has parameters.\n";
+            StmtBlock block = static_cast<StmtBlock>(node);
+            for (int i = block->getStmts()->len() - 1; i >= 0; --i)
+            {
+                work.push_back(block->getStmts()->nth(i));
+            }
+            for (int i = block->getVariableDecls()->len() - 1; i >= 0; --i)
+            {
+                work.push_back(block->getVariableDecls()->nth(i));
+            }
+            break;
+        }
+        case NODE_IF:
+            work.push_back(static_cast<IfStmt>(node)->getElse());
+            work.push_back(static_cast<IfStmt>(node)->getThen());
+            work.push_back(static_cast<IfStmt>(node)->getCondition());
+            break;
+        case NODE_WHILE:
+            work.push_back(static_cast<WhileStmt>(node)->getBody());
+            work.push_back(static_cast<WhileStmt>(node)->getCondition());
+            break;
+        case NODE_FOR:
+            work.push_back(static_cast<ForStmt>(node)->getBody());
+            work.push_back(static_cast<ForStmt>(node)->getLoop());
+            work.push_back(static_cast<ForStmt>(node)->getCondition());
+            work.push_back(static_cast<ForStmt>(node)->getInit());
+            break;
+        case NODE_RETURN:
+            work.push_back(static_cast<ReturnStmt>(node)->getValue());
+            break;
+        case NODE_CALL:
+        {
+            Actuals actuals = static_cast<Call>(node)->getActuals();
+            for (int i = actuals->len() - 1; i >= 0; --i)
+            {
+                work.push_back(actuals->nth(i));
+            }
+            break;
+        }
+        default:
+            // every other expression has at most two operands
+            if (node->get_kind() > NODE_CALL)
+            {
+                Expr expr = static_cast<Expr>(node);
+                Expr first = expr->getChild(0);
+                if (first)
+                {
+                    Expr second = expr->getChild(1);
+                    if (second)
+                    {
+                        work.push_back(second);
+                    }
+                    work.push_back(first);
+                }
+            }
+            break;
         }
     }
 }
 
-void VariableDecl_class::check()
+// FNV-1a, 64 bits.
+static CheckCache::Key mix(CheckCache::Key h, unsigned long long value)
 {
-    Symbol name = getName();
-    Symbol type = getType();
-    bool isNotExisted = true;
-    bool isNotValidType = true;
-    if (objectEnv.probe(name) != NULL)
-    {
-        isNotExisted = false;
-        semant_error(this) << "This variable has been defined before.\n";
-    }
-    if (!isValidTypeName(type))
-    {
-        isNotValidType = false;
-        semant_error(this) << "This variable doesn't have a correct type.\n";
-    }
-    if (isNotExisted && isNotValidType)
-    {
-        objectEnv.addid(name, new Symbol(type));
-    }
+    return (h ^ value) * 1099511628211ULL;
 }
 
-void CallDecl_class::check()
+// Symbols are mixed in by index: the cache is cleared with idtable, so
+// an index names the same string for as long as a key is kept.
+static CheckCache::Key mixSymbol(CheckCache::Key h, Symbol sym)
 {
-    bool isReturnExisted = false;
-    objectEnv.enterscope();
-    if (!sameType(*objectEnv.lookup(name), returnType))
-    {
-        semant_error(this) << "This function's return type doesn't match its declaration's.\n";
-    }
-    if (paras->len() > 6)
-    {
-        semant_error(this) << "This function has more than 6 parameters.\n";
-    }
-    for (int i = paras->first(); paras->more(i); i = paras->next(i))
+    return mix(h, sym ? sym->get_index() + 1 : 0);
+}
+
+// What name stands for in the whole program, as a global variable and
+// as the callee of a call; the low bit is set if it names a function.
+static CheckCache::Key globalMeaning(Symbol name)
+{
+    CheckCache::Key h = 2;
+    ObjectInfo *info = context->objectEnv.lookup(name);
+    if (info)
     {
-        Variable para = paras->nth(i);
-        if (!isValidTypeName(para->getName()))
-        {
-            semant_error(this) << "One of the function's parameters has an incorrect type.\n";
-        }
-        else
-        {
-            objectEnv.addid(para->getName(), new Symbol(para->getType()));
-        }
+        h = mixSymbol(h, info->type);
+        h = mix(h, info->slot);
     }
-    StmtBlock body = getBody();
-    Stmts bodyStmts = body->getStmts();
-    body->check(getType());
-    for (int i = bodyStmts->first(); bodyStmts->more(i); i = bodyStmts->next(i))
+    h = mix(h, info != NULL);
+
+    std::map<Symbol, CallDecl>::iterator it = context->callMap.find(name);
+    if (it != context->callMap.end())
     {
-        Stmt stmt = bodyStmts->nth(i);
-        if (stmt->isReturnStmt())
+        CallDecl callee = it->second;
+        h = mixSymbol(h, callee->getType());
+        for (Variable para : *callee->getVariables())
         {
-            isReturnExisted = true;
-            break;
+            h = mixSymbol(h, para->getType());
         }
+        h = mix(h, callee->getVariables()->len());
     }
-    if (!isReturnExisted)
+    h = mix(h, it != context->callMap.end());
+    return (h & ~(CheckCache::Key)3) | 2 | (context->callsByName.count(name) != 0);
+}
+
+// Fill nameMeanings for the global names of the program.  Any other
+// name stands for nothing outside a function and keeps 0.
+static void initialize_name_meanings(Decls decls)
+{
+    context->nameMeanings.assign(idtable.size(), 0);
+    for (Decl decl : *decls)
     {
-        semant_error(this) << "Function main must have an overall return statement.\n";
+        context->nameMeanings[decl->getName()->get_index()] = globalMeaning(decl->getName());
     }
-    objectEnv.exitscope();
 }
 
-void StmtBlock_class::check(Symbol type)
+// Mix in what name stands for outside the function being checked.  For
+// the name of a function this also depends on which of the functions of
+// that name are declared before the one being checked.
+static CheckCache::Key mixMeaning(CheckCache::Key h, Symbol name)
 {
-    objectEnv.enterscope();
-    for (int i = vars->first(); vars->more(i); i = vars->next(i))
+    CheckCache::Key meaning = 0;
+    if (name->get_index() < (int)context->nameMeanings.size())
     {
-        VariableDecl var = vars->nth(i);
-        var->check();
+        meaning = context->nameMeanings[name->get_index()];
     }
-    for (int i = stmts->first(); stmts->more(i); i = stmts->next(i))
+    h = mix(h, meaning);
+    if (meaning & 1)
     {
-        Stmt stmt = stmts->nth(i);
-        stmt->check(type);
+        ObjectInfo *info = lookupGlobal(name);
+        h = mix(h, info ? info->kind * 0x10000 + info->slot : -1);
     }
-    objectEnv.exitscope();
+    return h;
 }
 
-void IfStmt_class::check(Symbol type)
+// Mix in what call's own name stands for where call is checked: the
+// type and arity of the function that calls of the name reach, and
+// whether an earlier function has the name too.  Unlike mixMeaning this
+// leaves out call's position among the functions, so adding or removing
+// one before it leaves its key alone.
+static CheckCache::Key mixOwnName(CheckCache::Key h, CallDecl call)
 {
-    if (!sameType(condition->checkType(), Bool))
+    std::map<Symbol, CallDecl>::iterator it = context->callMap.find(call->getName());
+    if (it != context->callMap.end())
     {
-        semant_error(this) << "This \"if\" statement's condition has a wrong type.\n";
+        h = mixSymbol(h, it->second->getType());
+        h = mix(h, it->second->getVariables()->len());
     }
-    thenexpr->check(type);
-    elseexpr->check(type);
+    h = mix(h, it != context->callMap.end());
+    return mix(h, context->callsByName.find(call->getName())->second.front() != currentCall);
 }
 
-void WhileStmt_class::check(Symbol type)
+// The fingerprint of call.  The walk also lists the expressions of call
+// in exprs, in preorder, for recordResult and applyResult.
+static CheckCache::Key fingerprint(CallDecl call, std::vector<Expr> &exprs)
 {
-    if (!sameType(condition->checkType(), Bool))
+    CheckCache::Key h = 14695981039346656037ULL;
+    exprs.clear();
+    walkCall(call, [&](tree_node *node)
     {
-        semant_error(this) << "This \"while\" statement's condition has a wrong type.\n";
-    }
-    ++isInLoop;
-    body->check(type);
-    --isInLoop;
+        h = mix(h, node->get_kind());
+        h = mix(h, node->get_line_number() - call->get_line_number());
+        switch (node->get_kind())
+        {
+        case NODE_CALL_DECL:
+            h = mixSymbol(h, call->getName());
+            h = mixSymbol(h, call->getType());
+            h = mixOwnName(h, call);
+            break;
+        case NODE_VARIABLE:
+            h = mixSymbol(h, static_cast<Variable>(node)->getName());
+            h = mixSymbol(h, static_cast<Variable>(node)->getType());
+            break;
+        case NODE_VARIABLE_DECL:
+            h = mixSymbol(h, static_cast<VariableDecl>(node)->getName());
+            h = mixSymbol(h, static_cast<VariableDecl>(node)->getType());
+            break;
+        case NODE_CALL:
+            h = mixSymbol(h, static_cast<Call>(node)->getName());
+            h = mixMeaning(h, static_cast<Call>(node)->getName());
+            break;
+        case NODE_ASSIGN:
+            h = mixSymbol(h, static_cast<Assign_class *>(node)->getLValue());
+            h = mixMeaning(h, static_cast<Assign_class *>(node)->getLValue());
+            break;
+        case NODE_OBJECT:
+            h = mixSymbol(h, static_cast<Object>(node)->getVar());
+            h = mixMeaning(h, static_cast<Object>(node)->getVar());
+            break;
+        default:
+            break;
+        }
+        if (node->get_kind() >= NODE_CALL)
+        {
+            exprs.push_back(static_cast<Expr>(node));
+        }
+    });
+    return h;
 }
 
-void ForStmt_class::check(Symbol type)
+// The name and type of call, then the name and type of each parameter.
+static void signatureOf(CallDecl call, std::vector<Symbol> &signature)
 {
-    if (!initexpr->is_empty_Expr())
+    signature.assign({call->getName(), call->getType()});
+    for (Variable para : *call->getVariables())
     {
-        initexpr->checkType();
-    }
-    if (!condition->is_empty_Expr())
-    {
-        condition->checkType();
+        signature.push_back(para->getName());
+        signature.push_back(para->getType());
     }
-    if (!loopact->is_empty_Expr())
+}
+
+// Split the diagnostics text that checking call wrote into the messages
+// marks found, with their lines made relative to call's.
+static void recordDiagnostics(CallDecl call, const std::string &text,
+                              const std::vector<DiagnosticMark> &marks,
+                              std::vector<CheckCache::Diagnostic> &diagnostics)
+{
+    diagnostics.resize(marks.size());
+    for (size_t i = 0; i < marks.size(); ++i)
     {
-        loopact->checkType();
+        size_t end = text.size();
+        if (i + 1 < marks.size())
+        {
+            // back over the next one's line and ": "
+            end = marks[i + 1].start - std::to_string(marks[i + 1].line).size() - 2;
+        }
+        diagnostics[i].line = marks[i].line - call->get_line_number();
+        diagnostics[i].message = text.substr(marks[i].start, end - marks[i].start);
     }
-    ++isInLoop;
-    body->check(type);
-    --isInLoop;
 }
 
-void ReturnStmt_class::check(Symbol type)
+// Copy what checking call set on its expressions into result.
+static void recordResult(CallDecl call, std::vector<Expr> &exprs, CheckCache::Result &result)
 {
-    if ((value->is_empty_Expr() && !sameType(type, Void)) || !sameType(value->checkType(), type))
-    {
-        semant_error(this) << "Returns " << value->getType() << " , but need " << type << "\n";
+    result.exprs.resize(exprs.size());
+    for (size_t i = 0; i < exprs.size(); ++i)
+    {
+        CheckCache::ExprResult &r = result.exprs[i];
+        r.type = exprs[i]->getType();
+        r.slotKind = SLOT_NONE;
+        r.slot = 0;
+        if (exprs[i]->get_kind() == NODE_ASSIGN)
+        {
+            r.slotKind = static_cast<Assign_class *>(exprs[i])->getSlotKind();
+            r.slot = static_cast<Assign_class *>(exprs[i])->getSlot();
+        }
+        else if (exprs[i]->get_kind() == NODE_OBJECT)
+        {
+            r.slotKind = static_cast<Object>(exprs[i])->getSlotKind();
+            r.slot = static_cast<Object>(exprs[i])->getSlot();
+        }
     }
+    result.frameSize = call->getFrameSize();
 }
 
-void ContinueStmt_class::check(Symbol type)
+// Set on call and its expressions what result recorded.
+static void applyResult(CallDecl call, std::vector<Expr> &exprs, const CheckCache::Result &result)
 {
-    if (!isInLoop)
+    for (size_t i = 0; i < exprs.size(); ++i)
     {
-        semant_error(this) << "This continue statement isn't in a loop.\n";
+        const CheckCache::ExprResult &r = result.exprs[i];
+        exprs[i]->setType(r.type);
+        if (exprs[i]->get_kind() == NODE_ASSIGN)
+        {
+            static_cast<Assign_class *>(exprs[i])->setSlot(r.slotKind, r.slot);
+        }
+        else if (exprs[i]->get_kind() == NODE_OBJECT)
+        {
+            static_cast<Object>(exprs[i])->setSlot(r.slotKind, r.slot);
+        }
     }
+    call->setFrameSize(result.frameSize);
 }
 
-void BreakStmt_class::check(Symbol type)
+// Check the body of the ordinal-th function and put the names of the
+// functions it calls into called.  Without a cache it is simply checked.
+// With one, a cached result is applied, or the body is checked and its
+// result put into fresh for the caller to cache.
+static void check_call(CallDecl call, int ordinal, const CheckCache *cache,
+                       CheckCache::Key &key, CheckCache::Result *&fresh,
+                       std::vector<Symbol> &called)
 {
-    if (!isInLoop)
+    currentCall = ordinal;
+    calledNames = &called;
+    if (cache == NULL)
     {
-        semant_error(this) << "break must be used in a loop sentence.\n";
+        call->check();
+        return;
     }
+
+    static thread_local std::vector<Expr> exprs;
+    static thread_local std::vector<Symbol> signature;
+    key = fingerprint(call, exprs);
+    signatureOf(call, signature);
+    const CheckCache::Result *cached = cache->find(key, signature, exprs.size());
+    if (cached)
+    {
+        applyResult(call, exprs, *cached);
+        called = cached->calls;
+        for (const CheckCache::Diagnostic &d : cached->diagnostics)
+        {
+            *error_stream << call->get_line_number() + d.line << ": " << d.message;
+        }
+        context->errorCount += cached->errors;
+        return;
+    }
+
+    std::ostringstream diagnostics;
+    std::vector<DiagnosticMark> marks;
+    ostream *stream = error_stream;
+    error_stream = &diagnostics;
+    diagnosticMarks = &marks;
+    callErrors = 0;
+    call->check();
+    diagnosticMarks = NULL;
+    error_stream = stream;
+    *error_stream << diagnostics.str();
+
+    fresh = new CheckCache::Result();
+    fresh->signature = signature;
+    recordResult(call, exprs, *fresh);
+    recordDiagnostics(call, diagnostics.str(), marks, fresh->diagnostics);
+    fresh->errors = callErrors;
+    fresh->calls = called;
 }
 
-Symbol Call_class::checkType()
+//
+// The threads that check function bodies besides the calling thread.
+// They are started by the first run that needs them and kept for the
+// whole process, so programs checked one after another (batch mode, the
+// server) and the levels of semant -P do not start threads each time.
+//
+// run(workers, n, task) calls task(0) .. task(n - 1), spread over the
+// calling thread and the pool's threads, of which there are at least
+// workers, and returns once every call has returned.  Programs checked
+// on different threads (the compile server's, say) share the pool, so
+// a run waits for the one before it to finish.
+//
+class CheckPool
 {
-    std::map<Symbol, CallDecl>::iterator it = callMap.find(name);
-    if (it == callMap.end())
+private:
+    std::mutex running;         // held by the caller of run throughout
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    std::vector<std::thread> threads;
+    const std::function<void(int)> *task = NULL;
+    int count = 0;
+    std::atomic<int> next{0};
+    int busy = 0;               // pool threads not done with this run
+    unsigned long round = 0;    // the number of runs so far
+    bool stopping = false;
+
+    void take(const std::function<void(int)> &t, int n)
     {
-        semant_error(this) << "This function hasn't been defined.";
-        setType(Void);
+        for (int i = next++; i < n; i = next++)
+        {
+            t(i);
+        }
     }
-    else if (name->get_string() == print->get_string())
+
+    void work(unsigned long seen)
     {
-        if (actuals->len())
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
         {
-            semant_error(this) << "The printf function doesn't have parameters.\n";
+            wake.wait(lock, [&] { return stopping || round != seen; });
+            if (stopping)
+            {
+                return;
+            }
+            seen = round;
+            const std::function<void(int)> &t = *task;
+            int n = count;
+            lock.unlock();
+            take(t, n);
+            lock.lock();
+            if (--busy == 0)
+            {
+                done.notify_one();
+            }
         }
-        if (!sameType(actuals->nth(actuals->first())->getType(), String))
+    }
+
+public:
+    ~CheckPool()
+    {
         {
-            semant_error(this) << "The first paramter of the printf function isn't String.\n";
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
         }
-        for (int i = actuals->first(); actuals->more(i); i = actuals->next(i))
+        wake.notify_all();
+        for (std::thread &thread : threads)
         {
-            actuals->nth(i)->checkType();
+            thread.join();
         }
-        setType(Void);
     }
-    else
+
+    void run(int workers, int n, const std::function<void(int)> &t)
     {
-        CallDecl callDecl = it->second;
-        Variables variables = callDecl->getVariables();
-        int i = 0;
-        int j = 0;
-        int para_index = 1;
-        for (; variables->more(i) && actuals->more(j); i = variables->next(i), j = actuals->next(j))
+        std::lock_guard<std::mutex> turn(running);
         {
-            Actual actual = actuals->nth(i);
-            if (!sameType(variables->nth(i)->getType(), actual->checkType()))
+            std::lock_guard<std::mutex> lock(mutex);
+            while ((int)threads.size() < workers)
             {
-                semant_error(this) << "Function loop, the " << para_index << " parameter should be " << variables->nth(i)->getType() << " but provided a " << actual->getType() << ".\n";
-                return callDecl->getType();
+                threads.push_back(std::thread(&CheckPool::work, this, round));
             }
-            ++para_index;
-        }
-        if (variables->more(i) || actuals->more(j))
-        {
-            semant_error(this) << "The number of parameters don't match the declaration.\n";
+            task = &t;
+            count = n;
+            next = 0;
+            busy = threads.size();
+            round++;
         }
-        setType(callDecl->getType());
+        wake.notify_all();
+        take(t, n);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return busy == 0; });
     }
-    return type;
-}
+};
 
-Symbol Actual_class::checkType()
-{
-    setType(expr->checkType());
-    return type;
-}
+static CheckPool checkPool;
+
+// Fewer function bodies than this are checked on the calling thread
+// alone; waking the pool would cost more than it saves.
+#define PARALLEL_MIN_CALLS 32
 
-Symbol Assign_class::checkType()
+// Function bodies only read the global tables, so they are checked on
+// semant_jobs threads (one per core if it is 0) when there are enough
+// of them.  Threads take the next unchecked function in turn.  Each
+// function's diagnostics go to a buffer of their own; the buffers are
+// printed in declaration order, so the output is the same as when the
+// functions are checked one by one.  The cache is only read meanwhile;
+// new results go into it afterwards.
+//
+// Checking records which functions each one calls, and the calls of
+// each batch of functions checked go into a call graph: graph if it is
+// given, else one of check_calls' own.
+//
+// With semant -P only the functions main calls, directly or through
+// others, are checked: main first, then its callees in the graph, then
+// theirs, and so on.  The others are marked unreachable and neither
+// checked nor dumped, so errors in them are not reported.
+static void check_calls(Decls decls, CheckCache *cache, CallGraph *graph)
 {
-    Symbol valueType = value->checkType();
-    Symbol *type = objectEnv.lookup(lvalue);
-    if (!type)
+    std::vector<CallDecl> calls;
+    for (Decl decl : *decls)
     {
-        semant_error(this) << "This symbol hasn't been defined.\n";
-        setType(Void);
+        if (decl->isCallDecl())
+        {
+            context->callsByName[decl->getName()].push_back(calls.size());
+            context->callInfos.push_back(ObjectInfo{decl->getType(), SLOT_FUNCTION, (int)calls.size()});
+            calls.push_back(CallDecl(decl));
+        }
     }
-    else if ((sameType(*type, Float) && sameType(valueType, Int)) || (sameType(*type, Int) && sameType(valueType, Float)))
+
+    if (cache)
+    {
+        initialize_name_meanings(decls);
+    }
+    std::vector<CheckCache::Key> keys(calls.size());
+    std::vector<CheckCache::Result *> fresh(calls.size(), NULL);
+    std::vector<std::vector<Symbol> > called(calls.size());
+    int jobs = semant_jobs > 0 ? semant_jobs : std::thread::hardware_concurrency();
+    jobs = std::max(1, jobs);
+    bool buffered = jobs > 1 || semant_prune;
+    std::vector<std::ostringstream> diagnostics(buffered ? calls.size() : 0);
+    SemantContext *program = context;
+
+    CallGraph ownGraph;
+    CallGraph &calledBy = graph ? *graph : ownGraph;
+    calledBy.clear();
+    for (CallDecl call : calls)
     {
-        setType(*type);
+        calledBy.addFunction(call);
     }
-    else if (sameType(*type, valueType))
+    std::vector<int> lastCaller(calls.size(), -1);
+
+    // The function a called name stands for: the first of that name, the
+    // one callMap holds.
+    auto callee = [&](Symbol name)
+    {
+        return context->callsByName.find(name)->second.front();
+    };
+
+    // Check the functions numbered in todo and add their calls to the
+    // graph.
+    auto check_some = [&](const std::vector<int> &todo)
     {
-        setType(*type);
+        std::function<void(int)> check_one = [&](int t)
+        {
+            int i = todo[t];
+            context = program;
+            error_stream = buffered ? &diagnostics[i] : program->errors;
+            check_call(calls[i], i, cache, keys[i], fresh[i], called[i]);
+            calledNames = NULL;
+        };
+        if (jobs > 1 && (int)todo.size() >= PARALLEL_MIN_CALLS)
+        {
+            checkPool.run(jobs - 1, todo.size(), check_one);
+        }
+        else
+        {
+            for (int t = 0; t < (int)todo.size(); ++t)
+            {
+                check_one(t);
+            }
+        }
+        error_stream = program->errors;
+
+        for (int i : todo)
+        {
+            for (Symbol name : called[i])
+            {
+                int f = callee(name);
+                if (lastCaller[f] != i)
+                {
+                    lastCaller[f] = i;
+                    calledBy.addCall(i, f);
+                }
+            }
+        }
+    };
+
+    std::vector<bool> reached(calls.size(), !semant_prune);
+    if (!semant_prune)
+    {
+        std::vector<int> todo(calls.size());
+        for (int i = 0; i < (int)calls.size(); ++i)
+        {
+            todo[i] = i;
+        }
+        check_some(todo);
     }
-    else
+    else if (context->callMap.find(context->Main) != context->callMap.end())
     {
-        semant_error(this) << "Types of the left value and the right value don't match.\n";
-        setType(Void);
+        std::vector<int> todo(1, callee(context->Main));
+        reached[todo[0]] = true;
+        while (!todo.empty())
+        {
+            check_some(todo);
+            std::vector<int> following;
+            for (int i : todo)
+            {
+                for (int f : calledBy.callees(i))
+                {
+                    if (!reached[f])
+                    {
+                        reached[f] = true;
+                        following.push_back(f);
+                    }
+                }
+            }
+            todo.swap(following);
+        }
     }
-    return *type;
-}
-
-Symbol Add_class::checkType()
-{
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if (sameType(e1Type, Int) && (sameType(e2Type, Int)))
+    for (std::ostringstream &diagnostic : diagnostics)
     {
-        setType(Int);
+        *error_stream << diagnostic.str();
     }
-    else if ((sameType(e1Type, Int) && (sameType(e2Type, Float))) || (sameType(e1Type, Float) && (sameType(e2Type, Int))) || (sameType(e1Type, Float) && (sameType(e2Type, Float))))
+    for (size_t i = 0; i < calls.size(); ++i)
     {
-        setType(Float);
+        calls[i]->setReachable(reached[i]);
     }
-    else
+
+    if (cache)
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this addition expression are wrong.\n";
+        for (size_t i = 0; i < calls.size(); ++i)
+        {
+            if (fresh[i])
+            {
+                cache->insert(keys[i], *fresh[i]);
+                delete fresh[i];
+                cache->misses++;
+            }
+            else if (reached[i])
+            {
+                cache->hits++;
+            }
+        }
     }
-    return type;
 }
 
-Symbol Minus_class::checkType()
+static void check_main()
 {
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if (sameType(e1Type, Int) && (sameType(e2Type, Int)))
+    std::map<Symbol, CallDecl>::iterator it = context->callMap.find(context->Main);
+    if (it == context->callMap.end())
     {
-        setType(Int);
-    }
-    else if ((sameType(e1Type, Int) && (sameType(e2Type, Float))) || (sameType(e1Type, Float) && (sameType(e2Type, Int))) || (sameType(e1Type, Float) && (sameType(e2Type, Float))))
-    {
-        setType(Float);
+        semant_error() << "The main function doesn't exsits.\n";
     }
     else
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this substraction expression are wrong.\n";
+        CallDecl mainDecl = it->second;
+        if (!sameType(mainDecl->getType(), context->Void))
+        {
+            semant_error(mainDecl) << "Main function should have return type Void.\n";
+        }
+        if (mainDecl->getVariables()->len() > 0)
+        {
+            semant_error(mainDecl) << "The main function has parameters.\n";
+        }
     }
-    return type;
 }
 
-Symbol Multi_class::checkType()
+void VariableDecl_class::check()
 {
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if (sameType(e1Type, Int) && (sameType(e2Type, Int)))
+    Symbol name = getName();
+    Symbol type = getType();
+    bool isNotExisted = true;
+    bool isNotValidType = true;
+    if (localEnv.probe(name) != NULL)
     {
-        setType(Int);
+        isNotExisted = false;
+        semant_error(this) << "This variable has been defined before.\n";
     }
-    else if ((sameType(e1Type, Int) && (sameType(e2Type, Float))) || (sameType(e1Type, Float) && (sameType(e2Type, Int))) || (sameType(e1Type, Float) && (sameType(e2Type, Float))))
+    if (!isValidTypeName(type))
     {
-        setType(Float);
+        isNotValidType = false;
+        semant_error(this) << "This variable doesn't have a correct type.\n";
     }
-    else
+    if (isNotExisted && isNotValidType)
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this multiplication expression are wrong.\n";
+        localEnv.addid(name, ObjectInfo{type, SLOT_LOCAL, localSlots++});
+        maxLocalSlots = std::max(maxLocalSlots, localSlots);
     }
-    return type;
 }
 
-Symbol Divide_class::checkType()
+void CallDecl_class::check()
 {
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if (sameType(e1Type, Int) && (sameType(e2Type, Int)))
+    bool isReturnExisted = false;
+    int paraSlots = 0;
+    localEnv.enterscope();
+    localSlots = 0;
+    maxLocalSlots = 0;
+    if (!sameType(lookupObject(name)->type, returnType))
     {
-        setType(Int);
+        semant_error(this) << "This function's return type doesn't match its declaration's.\n";
     }
-    else if ((sameType(e1Type, Int) && (sameType(e2Type, Float))) || (sameType(e1Type, Float) && (sameType(e2Type, Int))) || (sameType(e1Type, Float) && (sameType(e2Type, Float))))
+    if (paras->len() > 6)
     {
-        setType(Float);
+        semant_error(this) << "This function has more than 6 parameters.\n";
     }
-    else
+    for (Variable para : *paras)
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this division expression are wrong.\n";
+        if (!isValidTypeName(para->getName()))
+        {
+            semant_error(this) << "One of the function's parameters has an incorrect type.\n";
+        }
+        else
+        {
+            localEnv.addid(para->getName(), ObjectInfo{para->getType(), SLOT_PARAM, paraSlots});
+        }
+        paraSlots++;
     }
-    return type;
-}
-
-Symbol Mod_class::checkType()
-{
-    if (sameType(e1->checkType(), Int) && sameType(e2->checkType(), Int))
+    StmtBlock body = getBody();
+    Stmts bodyStmts = body->getStmts();
+    body->check(getType());
+    frameSize = maxLocalSlots;
+    for (Stmt stmt : *bodyStmts)
     {
-        setType(Int);
+        if (stmt->isReturnStmt())
+        {
+            isReturnExisted = true;
+            break;
+        }
     }
-    else
+    if (!isReturnExisted)
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this mod expression are wrong.\n";
+        semant_error(this) << "Function main must have an overall return statement.\n";
     }
-    return type;
+    localEnv.exitscope();
 }
 
-Symbol Neg_class::checkType()
+void StmtBlock_class::check(Symbol type)
 {
-    Symbol tmpType = e1->checkType();
-    if (sameType(tmpType, Int) || sameType(tmpType, Float))
+    int outerSlots = localSlots;
+    localEnv.enterscope();
+    for (VariableDecl var : *vars)
     {
-        setType(tmpType);
+        var->check();
     }
-    else
+    for (Stmt stmt : *stmts)
     {
-        setType(Void);
-        semant_error(this) << "The type of the value in this negative expression is wrong.\n";
+        stmt->check(type);
     }
-    return type;
+    localEnv.exitscope();
+    localSlots = outerSlots;
 }
 
-Symbol Lt_class::checkType()
+void IfStmt_class::check(Symbol type)
 {
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if ((sameType(e1Type, Int) || sameType(e1Type, Float)) && (sameType(e2Type, Int) || sameType(e2Type, Float)))
+    if (!sameType(condition->checkType(), context->Bool))
     {
-        setType(Bool);
-    }
-    else
-    {
-        setType(Void);
-        semant_error(this) << "The types of two values of this lt expression are wrong.\n";
+        semant_error(this) << "This \"if\" statement's condition has a wrong type.\n";
     }
-    return type;
+    thenexpr->check(type);
+    elseexpr->check(type);
 }
 
-Symbol Le_class::checkType()
+void WhileStmt_class::check(Symbol type)
 {
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if ((sameType(e1Type, Int) || sameType(e1Type, Float)) && (sameType(e2Type, Int) || sameType(e2Type, Float)))
+    if (!sameType(condition->checkType(), context->Bool))
     {
-        setType(Bool);
-    }
-    else
-    {
-        setType(Void);
-        semant_error(this) << "The types of two values of this le expression are wrong.\n";
+        semant_error(this) << "This \"while\" statement's condition has a wrong type.\n";
     }
-    return type;
+    ++isInLoop;
+    body->check(type);
+    --isInLoop;
 }
 
-Symbol Equ_class::checkType()
+void ForStmt_class::check(Symbol type)
 {
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if ((sameType(e1Type, Int) || sameType(e1Type, Float)) && (sameType(e2Type, Int) || sameType(e2Type, Float)))
+    if (!initexpr->is_empty_Expr())
     {
-        setType(Bool);
+        initexpr->checkType();
     }
-    else
+    if (!condition->is_empty_Expr())
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this equ expression are wrong.\n";
+        condition->checkType();
     }
-    return type;
+    if (!loopact->is_empty_Expr())
+    {
+        loopact->checkType();
+    }
+    ++isInLoop;
+    body->check(type);
+    --isInLoop;
 }
 
-Symbol Neq_class::checkType()
+void ReturnStmt_class::check(Symbol type)
 {
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if (((sameType(e1Type, Int) || sameType(e1Type, Float)) && (sameType(e2Type, Int) || sameType(e2Type, Float))) || (sameType(e1Type, Bool) && sameType(e2Type, Bool)))
+    if ((value->is_empty_Expr() && !sameType(type, context->Void)) || !sameType(value->checkType(), type))
     {
-        setType(Bool);
-    }
-    else
-    {
-        setType(Void);
-        semant_error(this) << "The types of two values of this neq expression are wrong.\n";
+        semant_error(this) << "Returns " << value->getType() << " , but need " << type << "\n";
     }
-    return type;
 }
 
-Symbol Ge_class::checkType()
+void ContinueStmt_class::check(Symbol type)
 {
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if ((sameType(e1Type, Int) || sameType(e1Type, Float)) && (sameType(e2Type, Int) || sameType(e2Type, Float)))
-    {
-        setType(Bool);
-    }
-    else
+    if (!isInLoop)
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this ge expression are wrong.\n";
+        semant_error(this) << "This continue statement isn't in a loop.\n";
     }
-    return type;
 }
 
-Symbol Gt_class::checkType()
+void BreakStmt_class::check(Symbol type)
 {
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if ((sameType(e1Type, Int) || sameType(e1Type, Float)) && (sameType(e2Type, Int) || sameType(e2Type, Float)))
-    {
-        setType(Bool);
-    }
-    else
+    if (!isInLoop)
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this gt expression are wrong.\n";
+        semant_error(this) << "break must be used in a loop sentence.\n";
     }
-    return type;
 }
 
-Symbol And_class::checkType()
+//////////////////////////////////////////////////////////////////////
+//
+// Expression type checking
+//
+// Expressions are checked in post-order on an explicit work stack, not
+// by recursion, so how deeply an expression nests is limited only by
+// heap memory.  A frame remembers how many children of its expression
+// have been pushed; the types of checked children wait on the result
+// stack until their parent combines them.  Children are checked left
+// to right, so diagnostics come out in the order of a recursive walk.
+//
+//////////////////////////////////////////////////////////////////////
+
+struct ExprFrame
 {
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if (sameType(e1Type, Bool) && sameType(e2Type, Bool))
-    {
-        setType(Bool);
-    }
-    else
-    {
-        setType(Void);
-        semant_error(this) << "The types of two values of this and expression are wrong.\n";
+    Expr expr;
+    int next;        // children pushed so far
+    CallDecl callee; // called function, NULL for printf
+    Symbol result;   // type of a finished call
+};
+
+static Symbol popResult(std::vector<Symbol> &results)
+{
+    Symbol result = results.back();
+    results.pop_back();
+    return result;
+}
+
+static Operator operatorOf(NodeKind kind)
+{
+    switch (kind)
+    {
+    case NODE_ADD:
+        return OP_ADD;
+    case NODE_MINUS:
+        return OP_MINUS;
+    case NODE_MULTI:
+        return OP_MULTI;
+    case NODE_DIVIDE:
+        return OP_DIVIDE;
+    case NODE_MOD:
+        return OP_MOD;
+    case NODE_NEG:
+        return OP_NEG;
+    case NODE_LT:
+        return OP_LT;
+    case NODE_LE:
+        return OP_LE;
+    case NODE_EQU:
+        return OP_EQU;
+    case NODE_NEQ:
+        return OP_NEQ;
+    case NODE_GE:
+        return OP_GE;
+    case NODE_GT:
+        return OP_GT;
+    case NODE_AND:
+        return OP_AND;
+    case NODE_OR:
+        return OP_OR;
+    case NODE_XOR:
+        return OP_XOR;
+    case NODE_NOT:
+        return OP_NOT;
+    case NODE_BITAND:
+        return OP_BITAND;
+    case NODE_BITOR:
+        return OP_BITOR;
+    case NODE_BITNOT:
+        return OP_BITNOT;
+    default:
+        return OP_COUNT;
     }
-    return type;
 }
 
-Symbol Or_class::checkType()
+// A call checks each actual against its parameter as soon as the actual
+// is checked, and stops at the first mismatch.  Returns the next actual
+// to check, or NULL once frame.result holds the type of the call.
+static Expr nextActual(ExprFrame &frame, std::vector<Symbol> &results)
 {
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if (sameType(e1Type, Bool) && sameType(e2Type, Bool))
+    Call call = static_cast<Call>(frame.expr);
+    Actuals actuals = call->getActuals();
+    if (frame.next == 0)
     {
-        setType(Bool);
+        std::map<Symbol, CallDecl>::iterator it = context->callMap.find(call->getName());
+        if (it == context->callMap.end())
+        {
+            semant_error(call) << "This function hasn't been defined.";
+            call->setType(context->Void);
+            frame.result = call->getType();
+            return NULL;
+        }
+        if (call->getName()->get_string() == context->print->get_string())
+        {
+            if (actuals->len())
+            {
+                semant_error(call) << "The printf function doesn't have parameters.\n";
+            }
+            if (!sameType(actuals->nth(actuals->first())->getType(), context->String))
+            {
+                semant_error(call) << "The first paramter of the printf function isn't String.\n";
+            }
+        }
+        else
+        {
+            frame.callee = it->second;
+            calledNames->push_back(call->getName());
+        }
+    }
+    else if (frame.callee)
+    {
+        Symbol actualType = popResult(results);
+        Variable variable = frame.callee->getVariables()->nth(frame.next - 1);
+        if (!sameType(variable->getType(), actualType))
+        {
+            semant_error(call) << "Function loop, the " << frame.next << " parameter should be " << variable->getType() << " but provided a " << actuals->nth(frame.next - 1)->getType() << ".\n";
+            frame.result = frame.callee->getType();
+            return NULL;
+        }
     }
     else
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this or expression are wrong.\n";
+        popResult(results);
     }
-    return type;
-}
 
-Symbol Xor_class::checkType()
-{
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if (sameType(e1Type, Bool) && sameType(e2Type, Bool))
+    if (!frame.callee)
     {
-        setType(Bool);
+        if (frame.next < actuals->len())
+        {
+            return actuals->nth(frame.next);
+        }
+        call->setType(context->Void);
     }
     else
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this xor expression are wrong.\n";
+        Variables variables = frame.callee->getVariables();
+        if (frame.next < actuals->len() && frame.next < variables->len())
+        {
+            return actuals->nth(frame.next);
+        }
+        if (actuals->len() != variables->len())
+        {
+            semant_error(call) << "The number of parameters don't match the declaration.\n";
+        }
+        call->setType(frame.callee->getType());
     }
-    return type;
+    frame.result = call->getType();
+    return NULL;
 }
 
-Symbol Not_class::checkType()
+// Returns the next child of frame.expr to check, or NULL when all of
+// its children have been checked.
+static Expr nextChild(ExprFrame &frame, std::vector<Symbol> &results)
 {
-    Symbol tmpType = e1->checkType();
-    if (sameType(tmpType, Bool))
+    if (frame.expr->get_kind() == NODE_CALL)
     {
-        setType(Bool);
+        return nextActual(frame, results);
     }
-    else
-    {
-        setType(Void);
-        semant_error(this) << "The types of two values of this not expression are wrong.\n";
-    }
-    return type;
+    return frame.expr->getChild(frame.next);
 }
 
-Symbol Bitand_class::checkType()
+static Symbol checkAssign(Assign_class *assign, Symbol valueType)
 {
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if (sameType(e1Type, Int) && sameType(e2Type, Int))
+    ObjectInfo *info = lookupObject(assign->getLValue());
+    if (!info)
     {
-        setType(Int);
+        semant_error(assign) << "This symbol hasn't been defined.\n";
+        assign->setType(context->Void);
+        return context->Void;
     }
-    else
+    assign->setSlot(info->kind, info->slot);
+    if ((typeId(info->type) == TYPE_FLOAT && typeId(valueType) == TYPE_INT) || (typeId(info->type) == TYPE_INT && typeId(valueType) == TYPE_FLOAT))
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this bitand expression are wrong.\n";
+        assign->setType(info->type);
     }
-    return type;
-}
-
-Symbol Bitor_class::checkType()
-{
-    Symbol e1Type = e1->checkType();
-    Symbol e2Type = e2->checkType();
-    if (sameType(e1Type, Int) && sameType(e2Type, Int))
+    else if (sameType(info->type, valueType))
     {
-        setType(Int);
+        assign->setType(info->type);
     }
     else
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this bitor expression are wrong.\n";
+        semant_error(assign) << "Types of the left value and the right value don't match.\n";
+        assign->setType(context->Void);
     }
-    return type;
+    return info->type;
 }
 
-Symbol Bitnot_class::checkType()
+static Symbol checkObject(Object object)
 {
-    Symbol tmpType = e1->checkType();
-    if (sameType(tmpType, Int))
+    ObjectInfo *info = lookupObject(object->getVar());
+    if (info)
     {
-        setType(Int);
+        object->setType(info->type);
+        object->setSlot(info->kind, info->slot);
     }
     else
     {
-        setType(Void);
-        semant_error(this) << "The types of two values of this bitnot expression are wrong.\n";
+        object->setType(context->Void);
+        semant_error(object) << "object " << object->getVar() << " has not been defined.\n";
     }
-    return type;
+    return object->getType();
 }
 
-Symbol Const_int_class::checkType()
+// Called once all children of frame.expr have been checked; their types
+// are on top of the result stack, the last child on top.
+static Symbol finishExpr(ExprFrame &frame, std::vector<Symbol> &results)
 {
-    setType(Int);
-    return type;
-}
-
-Symbol Const_string_class::checkType()
-{
-    setType(String);
-    return type;
-}
-
-Symbol Const_float_class::checkType()
-{
-    setType(Float);
-    return type;
-}
-
-Symbol Const_bool_class::checkType()
-{
-    setType(Bool);
-    return type;
+    Expr expr = frame.expr;
+    switch (expr->get_kind())
+    {
+    case NODE_CALL:
+        return frame.result;
+    case NODE_ACTUAL:
+        expr->setType(popResult(results));
+        return expr->getType();
+    case NODE_ASSIGN:
+        return checkAssign(static_cast<Assign_class *>(expr), popResult(results));
+    case NODE_ADD:
+    case NODE_MINUS:
+    case NODE_MULTI:
+    case NODE_DIVIDE:
+    case NODE_MOD:
+    case NODE_LT:
+    case NODE_LE:
+    case NODE_EQU:
+    case NODE_NEQ:
+    case NODE_GE:
+    case NODE_GT:
+    case NODE_AND:
+    case NODE_OR:
+    case NODE_XOR:
+    case NODE_BITAND:
+    case NODE_BITOR:
+    {
+        Symbol right = popResult(results);
+        Symbol left = popResult(results);
+        return checkOperator(expr, operatorOf(expr->get_kind()), left, right);
+    }
+    case NODE_NEG:
+    case NODE_NOT:
+    case NODE_BITNOT:
+        return checkOperator(expr, operatorOf(expr->get_kind()), popResult(results), context->Void);
+    case NODE_CONST_INT:
+        return expr->setType(context->Int)->getType();
+    case NODE_CONST_STRING:
+        return expr->setType(context->String)->getType();
+    case NODE_CONST_FLOAT:
+        return expr->setType(context->Float)->getType();
+    case NODE_CONST_BOOL:
+        return expr->setType(context->Bool)->getType();
+    case NODE_OBJECT:
+        return checkObject(static_cast<Object>(expr));
+    default:
+        return expr->setType(context->Void)->getType();
+    }
 }
 
-Symbol Object_class::checkType()
+Symbol Expr_class::checkType()
 {
-    bool flag = false;
-    Symbol *tmpType = objectEnv.lookup(var);
-    if (tmpType)
+    std::vector<ExprFrame> work;
+    std::vector<Symbol> results;
+    work.push_back(ExprFrame{this, 0, NULL, NULL});
+    while (!work.empty())
     {
-        setType(*tmpType);
-    }
-    else
-    {
-        setType(Void);
-        semant_error(this) << "object " << var <<  " has not been defined.\n";
+        Expr child = nextChild(work.back(), results);
+        if (child)
+        {
+            work.back().next++;
+            work.push_back(ExprFrame{child, 0, NULL, NULL});
+            continue;
+        }
+        Symbol result = finishExpr(work.back(), results);
+        work.pop_back();
+        results.push_back(result);
     }
-    return type;
+    return results.back();
 }
 
-Symbol No_expr_class::checkType()
+int Program_class::semant(ostream &errors, CheckCache *cache, CallGraph *graph)
 {
-    setType(Void);
-    return type;
-}
+    SemantContext program(errors);
+    SemantContext *outer = context;
+    ostream *outer_stream = error_stream;
+    context = &program;
+    error_stream = &errors;
 
-void Program_class::semant()
-{
-    objectEnv.enterscope();
+    context->objectEnv.enterscope();
     initialize_constants();
+    initialize_type_ids();
     install_calls(decls);
     check_main();
     install_globalVars(decls);
-    check_calls(decls);
-    objectEnv.exitscope();
+    check_calls(decls, cache, graph);
+    context->objectEnv.exitscope();
 
-    if (semant_errors > 0)
+    int count = context->errorCount;
+    if (count > 0)
     {
-        cerr << "Compilation halted due to static semantic errors." << endl;
-        exit(1);
+        errors << "Compilation halted due to static semantic errors." << endl;
     }
+    context = outer;
+    error_stream = outer_stream;
+    return count;
 }
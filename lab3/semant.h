@@ -5,11 +5,15 @@
 #include <iostream>  
 #include <map>
 #include <set>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <algorithm>
 #include "seal-decl.h"
 #include "seal-stmt.h"
 #include "seal-expr.h"
+#include "seal-visitor.h"
+#include "callgraph.h"
 #include "stringtab.h"
 #include "symtab.h"
 #include "list.h"
@@ -18,6 +22,110 @@
 #define TRUE 1
 #define FALSE 0
 
+// Compact ids of the built-in types, used by the type checker in place
+// of comparing type Symbols.  Every other type name is TYPE_OTHER.
+enum TypeId
+{
+    TYPE_INT,
+    TYPE_FLOAT,
+    TYPE_STRING,
+    TYPE_BOOL,
+    TYPE_VOID,
+    TYPE_OTHER,
+    TYPE_COUNT
+};
+
+// The operators whose typing rules are kept in the operator table.
+enum Operator
+{
+    OP_ADD,
+    OP_MINUS,
+    OP_MULTI,
+    OP_DIVIDE,
+    OP_MOD,
+    OP_NEG,
+    OP_LT,
+    OP_LE,
+    OP_EQU,
+    OP_NEQ,
+    OP_GE,
+    OP_GT,
+    OP_AND,
+    OP_OR,
+    OP_XOR,
+    OP_NOT,
+    OP_BITAND,
+    OP_BITOR,
+    OP_BITNOT,
+    OP_COUNT
+};
+
+//
+// CheckCache keeps what checking each function body produced: the types
+// and slots set on its nodes, its frame size and its diagnostics.  The
+// results are keyed by a fingerprint of the function and of what the
+// global names it uses stand for (see "Incremental checking" in
+// semant.cc), so Program_class::semant can reuse them for a function
+// that has not changed since an earlier program.  Line numbers in keys
+// and diagnostics count from the function's own line, so a function
+// that only moved is reused too.  A result is found only if the
+// function's signature and number of expressions also match, as a check
+// on the key.  Keys and results refer to Symbols of idtable, so the cache
+// must be cleared whenever idtable is.
+//
+class CheckCache
+{
+public:
+    typedef unsigned long long Key;
+
+    // What checking set on one expression; the slot only for an Object
+    // or an Assign.
+    struct ExprResult
+    {
+        Symbol type;
+        SlotKind slotKind;
+        int slot;
+    };
+
+    // One diagnostic, without the line it is printed after; line is
+    // counted from the function's line.
+    struct Diagnostic
+    {
+        int line;
+        std::string message;
+    };
+
+    struct Result
+    {
+        std::vector<Symbol> signature; // name, type, then each parameter's
+        std::vector<ExprResult> exprs; // in preorder
+        int frameSize;
+        std::vector<Diagnostic> diagnostics;
+        int errors;
+        std::vector<Symbol> calls; // names of the functions called
+    };
+
+    long hits, misses; // functions reused and checked
+
+    CheckCache() : hits(0), misses(0) {}
+
+    const Result *find(Key key, const std::vector<Symbol> &signature, size_t exprs) const
+    {
+        std::unordered_map<Key, Result>::const_iterator it = results.find(key);
+        if (it == results.end() || it->second.signature != signature ||
+            it->second.exprs.size() != exprs)
+        {
+            return NULL;
+        }
+        return &it->second;
+    }
+    void insert(Key key, Result &result) { results[key] = std::move(result); }
+    size_t size() const { return results.size(); }
+    void clear() { results.clear(); }
+
+private:
+    std::unordered_map<Key, Result> results;
+};
 
 // color
 
@@ -0,0 +1,53 @@
+#!/bin/bash
+#
+# Stress test for long expressions: checks a+a+...+a with 10^5 and 10^6
+# terms.  semant must accept both, and since checking and dumping do
+# not recurse, ten times the terms must take about ten times as long;
+# the test fails above 30 times.
+#
+#   bash stress.sh [semant]
+
+SEMANT=${1:-./semant}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+# gen terms file: a function whose one statement adds up terms a's
+gen() {
+    {
+        echo "Void func main() {"
+        echo "    Int a;"
+        printf "    a = a"
+        yes "+a" | head -n $(($1 - 1)) | tr -d '\n'
+        echo ";"
+        echo "    return;"
+        echo "}"
+    } > "$2"
+}
+
+# run file: prints the seconds semant takes, fails if semant does
+run() {
+    local start end
+    start=$(date +%s.%N)
+    "$SEMANT" "$1" > /dev/null
+    local status=$?
+    end=$(date +%s.%N)
+    if [ $status -ne 0 ]; then
+        echo "$1: semant exited with status $status" >&2
+        exit 1
+    fi
+    awk "BEGIN { print $end - $start }"
+}
+
+for terms in 100000 1000000; do
+    gen $terms "$DIR/$terms.seal"
+    secs[$terms]=$(run "$DIR/$terms.seal") || exit 1
+    echo "$terms terms: ${secs[$terms]} s"
+done
+
+ratio=$(awk "BEGIN { print ${secs[1000000]} / (${secs[100000]} + 0.01) }")
+printf "10x the terms took %.1fx the time\n" $ratio
+if awk "BEGIN { exit !($ratio > 30) }"; then
+    echo "NOT passed: time grows faster than the expression"
+    exit 1
+fi
+echo "Passed"
@@ -19,8 +19,26 @@ template class StringTable<StringEntry>;
 template class StringTable<IntEntry>;
 template class StringTable<FloatEntry>;
 
-Entry::Entry(char *s, int l, int i) : len(l), index(i) {
-  str = new char [len+1];
+//
+// FNV-1a over the first len characters of s.
+//
+unsigned int hash_string(char *s, int len)
+{
+  unsigned int h = 2166136261u;
+  for (int i = 0; i < len; i++) {
+    h ^= (unsigned char) s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+//
+// The string is copied into stringtab_arena.  StringTable allocates the
+// Entry itself from the same arena just before, so an Entry is
+// immediately followed by its characters.
+//
+Entry::Entry(char *s, int l, int i) : len(l), index(i), hash(hash_string(s, l)) {
+  str = (char *) stringtab_arena.alloc(len+1);
   strncpy(str, s, len);
   str[len] = '\0';
 }
@@ -76,7 +94,9 @@ IdEntry::IdEntry(char *s, int l, int i) : Entry(s,l,i) { }
 IntEntry::IntEntry(char *s, int l, int i) : Entry(s,l,i) { }
 FloatEntry::FloatEntry(char *s, int l, int i) : Entry(s,l,i) { }
 
-IdTable idtable;
-IntTable inttable;
-StrTable stringtable;
-FloatTable floattable;
\ No newline at end of file
+thread_local Arena stringtab_arena;
+
+thread_local IdTable idtable;
+thread_local IntTable inttable;
+thread_local StrTable stringtable;
+thread_local FloatTable floattable;
\ No newline at end of file
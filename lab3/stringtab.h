@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <string.h>
 #include "list.h" // list template
+#include "arena.h"
 #include "seal-io.h"
 
 class Entry;
@@ -19,6 +20,9 @@ typedef Entry *Symbol;
 extern ostream &operator<<(ostream &s, const Entry &sym);
 extern ostream &operator<<(ostream &s, Symbol sym);
 
+// hash of the first len characters of s; used to index the string tables
+extern unsigned int hash_string(char *s, int len);
+
 /////////////////////////////////////////////////////////////////////////
 //
 //  String Table Entries
@@ -28,9 +32,10 @@ extern ostream &operator<<(ostream &s, Symbol sym);
 class Entry
 {
 protected:
-  char *str; // the string
-  int len;   // the length of the string (without trailing \0)
-  int index; // a unique index for each string
+  char *str;         // the string
+  int len;           // the length of the string (without trailing \0)
+  int index;         // a unique index for each string
+  unsigned int hash; // hash_string(str, len), cached for the table index
 public:
   Entry(char *s, int l, int i);
 
@@ -40,6 +45,9 @@ public:
   // is the integer argument equal to the index of this Entry?
   bool equal_index(int ind) const { return ind == index; }
 
+  unsigned int get_hash() const { return hash; }
+  int get_index() const { return index; }
+
   ostream &print(ostream &s) const;
 
   // Return the str and len components of the Entry.
@@ -106,8 +114,15 @@ class StringTable
 protected:
   List<Elem> *tbl; // a string table is a list
   int index;       // the current index
+  Elem **entries;  // the entries of tbl, in index order
+  Elem **buckets;  // open-addressing hash index over the entries of tbl
+  int capacity;    // number of buckets (zero or a power of two)
+
+  Elem **find_slot(char *s, int len, unsigned int h); // probe the index
+  void grow();                                        // double the index
 public:
-  StringTable() : tbl((List<Elem> *)NULL), index(0) {} // an empty table
+  StringTable() : tbl((List<Elem> *)NULL), index(0), entries((Elem **)NULL),
+                  buckets((Elem **)NULL), capacity(0) {} // an empty table
   // The following methods each add a string to the string table.
   // Only one copy of each string is maintained.
   // Returns a pointer to the string table entry with the string.
@@ -121,6 +136,15 @@ public:
   // add the string representation of an integer
   Elem *add_int(long i);
 
+  int size() const { return index; } // number of entries
+
+  // forget every entry but keep the index arrays; the entries' memory
+  // is reclaimed by resetting stringtab_arena
+  void clear();
+
+  // exchange the entries and index arrays of the two tables
+  void swap(StringTable &other);
+
   // An iterator.
   int first();     // first index
   int more(int i); // are there more indices?
@@ -154,8 +178,12 @@ public:
   void code_string_table(ostream &, int classtag);
 };
 
-extern IdTable idtable;
-extern IntTable inttable;
-extern StrTable stringtable;
-extern FloatTable floattable;
+// Entries, their strings and the table's list cells are all allocated
+// from this arena; they live as long as the string tables do.
+extern thread_local Arena stringtab_arena;
+
+extern thread_local IdTable idtable;
+extern thread_local IntTable inttable;
+extern thread_local StrTable stringtable;
+extern thread_local FloatTable floattable;
 #endif
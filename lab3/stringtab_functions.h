@@ -6,15 +6,26 @@
 
 #include "seal-io.h"
 #define MAXSIZE 1000000
+#define MIN_BUCKETS 64   // initial size of a string table's hash index
 #define min(a,b) (a > b ? b : a)
 
 #include "stringtab.h"
 #include <stdio.h>
+#include <new>
 
 //
 // A string table is implemented a linked list of Entrys.  Each Entry
 // in the list has a unique string.
 //
+// The list is indexed by an open-addressing hash table (linear probing)
+// of Entry pointers, keyed by the hash cached in each Entry, so that
+// add_string and lookup_string do not have to scan the list.  The
+// entries are also kept in an array ordered by index, so that lookup
+// and walks over first/more/next are direct accesses.
+//
+// Entries and list cells are placed in stringtab_arena rather than
+// allocated one by one with new.
+//
 
 template <class Elem>
 Elem *StringTable<Elem>::add_string(char *s)
@@ -23,26 +34,83 @@ Elem *StringTable<Elem>::add_string(char *s)
 }
 
 //
-// Add a string requires two steps.  First, the list is searched; if the
+// find_slot probes the index for the string s of length len and hash h.
+// It returns the bucket holding the matching Entry, or the empty bucket
+// where such an Entry belongs.  The index must not be full.
+//
+template <class Elem>
+Elem **StringTable<Elem>::find_slot(char *s, int len, unsigned int h)
+{
+  unsigned int mask = capacity - 1;
+  for (unsigned int i = h & mask; ; i = (i + 1) & mask) {
+    Elem *e = buckets[i];
+    if (e == NULL || (e->get_hash() == h && e->equal_string(s,len)))
+      return &buckets[i];
+  }
+}
+
+//
+// grow doubles the number of buckets and re-inserts every Entry using
+// its cached hash; no strings are compared.  The entry array is resized
+// to half the number of buckets, the most entries the index may hold.
+//
+template <class Elem>
+void StringTable<Elem>::grow()
+{
+  Elem **old = buckets;
+  int old_capacity = capacity;
+
+  capacity = capacity ? capacity * 2 : MIN_BUCKETS;
+
+  Elem **old_entries = entries;
+  entries = new Elem *[capacity / 2];
+  for (int i = 0; i < index; i++)
+    entries[i] = old_entries[i];
+  delete [] old_entries;
+
+  buckets = new Elem *[capacity];
+  for (int i = 0; i < capacity; i++)
+    buckets[i] = NULL;
+
+  unsigned int mask = capacity - 1;
+  for (int i = 0; i < old_capacity; i++) {
+    if (old[i] == NULL)
+      continue;
+    unsigned int j = old[i]->get_hash() & mask;
+    while (buckets[j] != NULL)
+      j = (j + 1) & mask;
+    buckets[j] = old[i];
+  }
+  delete [] old;
+}
+
+//
+// Add a string requires two steps.  First, the index is probed; if the
 // string is found, a pointer to the existing Entry for that string is 
-// returned.  If the string is not found, a new Entry is created and added
-// to the list.
+// returned.  If the string is not found, a new Entry is created, added
+// to the list and recorded in the empty bucket the probe stopped at.
+// The index is kept at most half full.
 //
 template <class Elem>
 Elem *StringTable<Elem>::add_string(char *s, int maxchars)
 {
-  int len = min((int) strlen(s),maxchars);
-  for(List<Elem> *l = tbl; l; l = l->tl())
-    if (l->hd()->equal_string(s,len))
-      return l->hd();
+  int len = strnlen(s,maxchars);   // s need not be NUL-terminated
+  if (2 * (index + 1) > capacity)
+    grow();
+
+  Elem **slot = find_slot(s, len, hash_string(s, len));
+  if (*slot)
+    return *slot;
 
-  Elem *e = new Elem(s,len,index++);
-  tbl = new List<Elem>(e, tbl);
+  Elem *e = new (stringtab_arena.alloc(sizeof(Elem))) Elem(s,len,index);
+  tbl = new (stringtab_arena.alloc(sizeof(List<Elem>))) List<Elem>(e, tbl);
+  entries[index++] = e;
+  *slot = e;
   return e;
 }
 
 //
-// To look up a string, the list is scanned until a matching Entry is located.
+// To look up a string, the index is probed for a matching Entry.
 // If no such entry is found, an assertion failure occurs.  Thus, this function
 // is used only for strings that one expects to find in the table.
 //
@@ -50,25 +118,21 @@ template <class Elem>
 Elem *StringTable<Elem>::lookup_string(char *s)
 {
   int len = strlen(s);
-  for(List<Elem> *l = tbl; l; l = l->tl())
-    if (l->hd()->equal_string(s,len))
-      return l->hd();
-  assert(0);   // fail if string is not found
-  return NULL; // to avoid compiler warning
+  assert(capacity > 0);   // fail if the table is empty
+  Elem *e = *find_slot(s, len, hash_string(s, len));
+  assert(e);   // fail if string is not found
+  return e;
 }
 
 //
 // lookup is similar to lookup_string, but uses the index of the string
-// as the key.
+// as the key.  Indices are dense, so this is a direct access.
 //
 template <class Elem>
 Elem *StringTable<Elem>::lookup(int ind)
 {
-  for(List<Elem> *l = tbl; l; l = l->tl())
-    if (l->hd()->equal_index(ind))
-      return l->hd();
-  assert(0);   // fail if string is not found
-  return NULL; // to avoid compiler warning
+  assert(0 <= ind && ind < index);   // fail if string is not found
+  return entries[ind];
 }
 
 //
@@ -77,10 +141,42 @@ Elem *StringTable<Elem>::lookup(int ind)
 template <class Elem>
 Elem *StringTable<Elem>::add_int(long i)
 {
-  static char *buf = new char[20];
-  snprintf(buf, 20, "%ld", i);
+  char buf[20];
+  snprintf(buf, sizeof(buf), "%ld", i);
   return add_string(buf);
 }
+//
+// clear empties the table for the next program.  The entry array and
+// the buckets keep their size, so a program with about as many strings
+// as the previous one does not grow the index again.
+//
+template <class Elem>
+void StringTable<Elem>::clear()
+{
+  tbl = (List<Elem> *)NULL;
+  index = 0;
+  for (int i = 0; i < capacity; i++)
+    buckets[i] = NULL;
+}
+
+template <class Elem>
+void StringTable<Elem>::swap(StringTable &other)
+{
+  List<Elem> *t = tbl;
+  int i = index, c = capacity;
+  Elem **e = entries, **b = buckets;
+  tbl = other.tbl;
+  index = other.index;
+  entries = other.entries;
+  buckets = other.buckets;
+  capacity = other.capacity;
+  other.tbl = t;
+  other.index = i;
+  other.entries = e;
+  other.buckets = b;
+  other.capacity = c;
+}
+
 template <class Elem>
 int StringTable<Elem>::first()
 {
@@ -14,59 +14,68 @@
 #ifndef _SYMTAB_H_
 #define _SYMTAB_H_
 
-#include "list.h"
+#include <stdlib.h>
+#include <functional>
+#include <new>
+#include <vector>
+#include "seal-io.h"
 
 //
 // SymtabEnty<SYM,DAT> defines the entry for a symbol table that associates
-//    symbols of type `SYM' with data of type `DAT *'.
+//    symbols of type `SYM' with data of type `DAT', stored in the entry.
+//    An entry also records the scope it was added in and the entry for
+//    the same symbol that it hides, if any.
 //
 
 template <class SYM, class DAT>
 class SymtabEntry
 {
 private:
-    SYM id;    // the key field
-    DAT *info; // associated information for the symbol
+    SYM id;                // the key field
+    DAT info;              // associated information for the symbol
+    SymtabEntry *shadowed; // entry for `id' in an enclosing scope
+    int depth;             // number of scopes open when it was added
 public:
-    SymtabEntry(SYM x, DAT *y) : id(x), info(y) {}
+    SymtabEntry(SYM x, const DAT &y, SymtabEntry *s, int d) : id(x), info(y), shadowed(s), depth(d) {}
     SYM get_id() const { return id; }
-    DAT *get_info() const { return info; }
+    DAT *get_info() { return &info; }
+    SymtabEntry *get_shadowed() const { return shadowed; }
+    int get_depth() const { return depth; }
 };
 
 //
 // SymbolTable<SYM,DAT> describes a symbol table mapping symbols of
-//    type `SYM' to data of type `DAT *'.  It is implemented as a
-//    list of lists of `SymtabEntry<SYM,DAT> *'.  The inner list is
-//    a scope, a mapping from symbols to data, and the outer list is
-//    a list of scopes.
+//    type `SYM' to data of type `DAT'.  It is implemented as a hash
+//    table from each symbol to the innermost entry for it; an entry
+//    links to the entry it shadows, so every symbol has a stack of
+//    bindings.  The entries are also kept in an undo log in the order
+//    they were added, and each open scope remembers where it starts in
+//    the log.  Symbols are compared with `==' and hashed with std::hash.
 //
-//    `tbl' points to the current top scope.
+//    The log is a pool of fixed-size chunks that are kept when a scope
+//    is exited and reused by later scopes, so adding a symbol does not
+//    allocate once the table has held that many entries.  Entries never
+//    move; a pointer returned by lookup or probe stays valid until the
+//    scope of its entry is exited.
 //
-//    `enterscope' makes the table point to a new scope whose parent
-//       is the scope it pointed to previously.
+//    `enterscope' opens a new scope nested in the current one.
 //
-//    `exitscope' makes the table point to the parent scope of the
-//        current scope.  Note that the old child scope is not
-//        deallocated.  One may save the state of a symbol table
-//        at a given point by copying it with `operator ='
+//    `exitscope' closes the current scope.  The entries added in it
+//        are taken off the end of the log, each symbol gets back the
+//        entry it had before, and their storage goes back to the pool.
 //
 //    `addid(s,i)' adds a symbol table entry to the current scope of
-//        the symbol table mapping symbol `s' to data `d'.  The old
-//        top scope isn't modified; a new scope is created whose
-//        entry list is the new entry followed by the old entry list,
-//        and whose tail is the old top scope's parent.  The table
-//        is made to point to this new scope.
+//        the symbol table mapping symbol `s' to a copy of `i'.  It hides any
+//        entry for `s' in an enclosing scope until the scope is exited.
 //
-//    `lookup(s)' looks for the symbol `s', starting at the top scope
-//        and proceeding down the list of scopes until either an
-//        entry is found whose `get_id()' equals `s', or the end of
-//        the root scope is reached.  It returns the data item
-//        associated with the entry, or NULL if no such entry exists.
+//    `lookup(s)' returns a pointer to the data of the innermost entry
+//        for `s', or NULL if there is none.
 //
+//    `probe(s)' returns a pointer to the data of `s' if `s' was added
+//        in the current scope, and NULL otherwise.
 //
-//    `probe(s)' checks the top scope for an entry whose `get_id()'
-//        equals `s', and returns the entry's `get_info()' if
-//        found, and NULL otherwise.
+//    lookup and probe take constant expected time, independent of the
+//    number of scopes and entries.
 //
 //    `dump()' prints the symbols in the symbol table.
 //
@@ -75,20 +84,71 @@ template <class SYM, class DAT>
 class SymbolTable
 {
     typedef SymtabEntry<SYM, DAT> ScopeEntry;
-    typedef List<ScopeEntry> Scope;
-    typedef List<Scope> ScopeList;
+
+    // A slot of the hash index.  Slots are never emptied; `top' is
+    // NULL while the symbol has no entry in any open scope.
+    struct Slot
+    {
+        SYM id;
+        ScopeEntry *top;
+        bool used;
+    };
+
+    enum { MIN_SLOTS = 64, CHUNK_ENTRIES = 256 };
 
 private:
-    ScopeList *tbl;
+    std::vector<Slot> slots;          // open addressing, linear probing
+    int used;                         // number of used slots
+    std::vector<ScopeEntry *> chunks; // storage of the log
+    size_t count;                     // number of entries in the log
+    std::vector<size_t> scopes;       // start of each open scope in the log
+
+    // The i-th entry of the log, in the order entries were added.
+    ScopeEntry *entry(size_t i)
+    {
+        return chunks[i / CHUNK_ENTRIES] + i % CHUNK_ENTRIES;
+    }
+
+    static size_t hash(SYM s)
+    {
+        size_t h = std::hash<SYM>()(s);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // The slot holding `s', or the empty slot where it belongs.
+    Slot &find_slot(SYM s)
+    {
+        size_t mask = slots.size() - 1;
+        size_t i = hash(s) & mask;
+        while (slots[i].used && !(slots[i].id == s))
+            i = (i + 1) & mask;
+        return slots[i];
+    }
+
+    void grow()
+    {
+        std::vector<Slot> old(slots.size() * 2);
+        old.swap(slots);
+        for (size_t i = 0; i < old.size(); i++)
+            if (old[i].used)
+                find_slot(old[i].id) = old[i];
+    }
+
+    SymbolTable(const SymbolTable &);
+    SymbolTable &operator=(const SymbolTable &);
 
 public:
-    SymbolTable() : tbl(NULL) {} // create a new symbol table
+    SymbolTable() : slots(MIN_SLOTS), used(0), count(0) {} // create a new symbol table
 
-    // Create pointer to current symbol table.
-    SymbolTable &operator=(const SymbolTable &s)
+    ~SymbolTable()
     {
-        tbl = s.tbl;
-        return *this;
+        while (count > 0)
+            entry(--count)->~ScopeEntry();
+        for (size_t i = 0; i < chunks.size(); i++)
+            ::operator delete(chunks[i]);
     }
 
     void fatal_error(char *msg)
@@ -97,37 +157,52 @@ public:
         exit(1);
     }
 
-    // Enter a new scope.  A symbol table is organized as a list of
-    // lists.  The head of the list is the innermost scope, the tail
-    // holds the outer scopes.  A scope must be entered before anything
+    // Enter a new scope.  A scope must be entered before anything
     // can be added to the table.
 
     void enterscope()
     {
-        // The cast of NULL is required for template instantiation to work
-        // correctly.
-        tbl = new ScopeList((Scope *)NULL, tbl);
+        scopes.push_back(count);
     }
 
-    // Pop the first scope off of the symbol table.
+    // Pop the innermost scope off of the symbol table.
     void exitscope()
     {
         // It is an error to exit a scope that doesn't exist.
-        if (tbl == NULL)
+        if (scopes.empty())
         {
             fatal_error("exitscope: Can't remove scope from an empty symbol table.");
         }
-        tbl = tbl->tl();
+        size_t start = scopes.back();
+        scopes.pop_back();
+        while (count > start)
+        {
+            ScopeEntry *se = entry(--count);
+            find_slot(se->get_id()).top = se->get_shadowed();
+            se->~ScopeEntry();
+        }
     }
 
     // Add an item to the symbol table.
-    ScopeEntry *addid(SYM s, DAT *i)
+    ScopeEntry *addid(SYM s, const DAT &i)
     {
         // There must be at least one scope to add a symbol.
-        if (tbl == NULL)
+        if (scopes.empty())
             fatal_error("addid: Can't add a symbol without a scope.");
-        ScopeEntry *se = new ScopeEntry(s, i);
-        tbl = new ScopeList(new Scope(se, tbl->hd()), tbl->tl());
+        if (2 * (used + 1) > (int)slots.size())
+            grow();
+        Slot &slot = find_slot(s);
+        if (!slot.used)
+        {
+            slot.id = s;
+            slot.top = NULL;
+            slot.used = true;
+            used++;
+        }
+        if (count == chunks.size() * CHUNK_ENTRIES)
+            chunks.push_back((ScopeEntry *)::operator new(CHUNK_ENTRIES * sizeof(ScopeEntry)));
+        ScopeEntry *se = new (entry(count++)) ScopeEntry(s, i, slot.top, scopes.size());
+        slot.top = se;
         return (se);
     }
 
@@ -137,47 +212,38 @@ public:
 
     DAT *lookup(SYM s)
     {
-        for (ScopeList *i = tbl; i != NULL; i = i->tl())
-        {
-            for (Scope *j = i->hd(); j != NULL; j = j->tl())
-            {
-                if (s == j->hd()->get_id())
-                {
-                    return (j->hd()->get_info());
-                }
-            }
-        }
-        return NULL;
+        ScopeEntry *se = find_slot(s).top;
+        return se ? se->get_info() : NULL;
     }
 
     // probe the symbol table.  Check the top scope (only) for the item
     // 's'.  If found, return the information field.  If not return NULL.
     DAT *probe(SYM s)
     {
-        if (tbl == NULL)
+        if (scopes.empty())
         {
             fatal_error("probe: No scope in symbol table.");
         }
-        for (Scope *i = tbl->hd(); i != NULL; i = i->tl())
+        ScopeEntry *se = find_slot(s).top;
+        if (se && se->get_depth() == (int)scopes.size())
         {
-            if (s == i->hd()->get_id())
-            {
-                return (i->hd()->get_info());
-            }
+            return (se->get_info());
         }
         return (NULL);
     }
 
-    // Prints out the contents of the symbol table
+    // Prints out the contents of the symbol table, innermost scope first
     void dump()
     {
-        for (ScopeList *i = tbl; i != NULL; i = i->tl())
+        size_t end = count;
+        for (size_t i = scopes.size(); i-- > 0;)
         {
             cerr << "\nScope: \n";
-            for (Scope *j = i->hd(); j != NULL; j = j->tl())
+            for (size_t j = end; j-- > scopes[i];)
             {
-                cerr << "  " << j->hd()->get_id() << endl;
+                cerr << "  " << entry(j)->get_id() << endl;
             }
+            end = scopes[i];
         }
     }
 };
@@ -16,14 +16,14 @@ int main(int argc, char *argv[]) {
   map->enterscope();
   
   // add a couple of entries mapping name to age.
-  // note the second argument must be a pointer to an integer
-  map->addid(Fred, new int(22));
-  map->addid(Mary, new int(25));
+  // the table keeps its own copy of each age
+  map->addid(Fred, 22);
+  map->addid(Mary, 25);
 
   // add a scope, add more names:
   map->enterscope();
-  map->addid(Miguel, new int(35));
-  map->addid(Mary, new int(23));
+  map->addid(Miguel, 35);
+  map->addid(Mary, 23);
 
   // check whether Fred is in the current scope; predicate is false
   cout << ((map->probe(Fred) != NULL) ? "Yes\n" : "No\n");
@@ -0,0 +1,169 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <sstream>
+#include <string>
+#include "token-pipe.h"
+#include "stringtab.h"
+#include "utilities.h"
+
+extern thread_local FILE *fin;
+extern thread_local char *curr_filename;
+extern thread_local int curr_lineno;
+extern thread_local ostream *lex_errors;
+extern int seal_yyparse(void);
+extern int seal_yylex(void);
+extern int yylex_destroy(void);
+extern bool map_input_file(const char *filename);
+extern void unmap_input_file(void);
+
+// Kinds of the last token the lexer thread sends when it cannot go on.
+enum
+{
+  TOKEN_NO_INPUT = -1,   // the file cannot be read
+  TOKEN_FATAL = -2       // the lexer reported a fatal error
+};
+
+// The string tables of the thread running the parser.
+struct StringTables
+{
+  Arena *arena;
+  IdTable *ids;
+  IntTable *ints;
+  StrTable *strings;
+  FloatTable *floats;
+};
+
+// Exchange this thread's string tables with t.
+static void swap_string_tables(const StringTables &t)
+{
+  stringtab_arena.swap(*t.arena);
+  idtable.swap(*t.ids);
+  inttable.swap(*t.ints);
+  stringtable.swap(*t.strings);
+  floattable.swap(*t.floats);
+}
+
+// Push the tokens of the input into ring, up to but not including the
+// end, or until the ring is closed.  Returns 0, or TOKEN_FATAL.
+static int scan_tokens(TokenRing &ring)
+{
+  jmp_buf input_error;
+  input_error_jump = &input_error;
+  if (setjmp(input_error) != 0) {
+    input_error_jump = NULL;
+    return TOKEN_FATAL;
+  }
+  int kind;
+  Token *t;
+  while ((kind = seal_yylex()) != 0 && (t = ring.slot()) != NULL) {
+    t->kind = kind;
+    t->line = curr_lineno;
+    t->value = seal_yylval;
+    ring.push();
+  }
+  input_error_jump = NULL;
+  return 0;
+}
+
+// A file being lexed on one thread and parsed on another.
+struct Pipeline
+{
+  TokenRing ring;
+  std::string error;   // the lexer's message for TOKEN_FATAL
+  std::thread lexer;
+};
+
+//
+// The lexer thread.  It works on the parser thread's string tables by
+// swapping them with its own, which are empty, for as long as it runs.
+// The token ending the input is pushed last, after the tables are given
+// back, so the parser thread finds them in place once it has seen it.
+//
+static void run_lexer(Pipeline *pipe, char *filename, char *name, StringTables tables)
+{
+  swap_string_tables(tables);
+  curr_filename = name;
+  curr_lineno = 1;
+  std::ostringstream errors;
+  lex_errors = &errors;
+  int last;
+  fin = NULL;
+  if (!map_input_file(filename) && (fin = fopen(filename, "r")) == NULL) {
+    last = TOKEN_NO_INPUT;
+  } else {
+    last = scan_tokens(pipe->ring);
+    unmap_input_file();
+    if (fin != NULL)
+      fclose(fin);
+  }
+  yylex_destroy();
+  lex_errors = &cerr;
+  swap_string_tables(tables);
+
+  Token *t = pipe->ring.slot();
+  if (t != NULL) {
+    pipe->error = errors.str();
+    t->kind = last;
+    t->line = curr_lineno;
+    pipe->ring.push();
+  }
+}
+
+static thread_local Pipeline *pipeline = NULL;
+
+static void finish_pipeline()
+{
+  pipeline->ring.close();
+  pipeline->lexer.join();
+  delete pipeline;
+  pipeline = NULL;
+  seal_yytoken_source = NULL;
+}
+
+static int next_piped_token()
+{
+  const Token &t = pipeline->ring.front();
+  curr_lineno = t.line;
+  if (t.kind == TOKEN_FATAL) {
+    cerr << pipeline->error;
+    fatal_input_error(-1);
+  }
+  seal_yylval = t.value;
+  int kind = t.kind;
+  if (kind != 0)
+    pipeline->ring.pop();   // the end stays, for the parser may ask again
+  return kind;
+}
+
+bool parse_pipelined(char *filename)
+{
+  StringTables tables = {&stringtab_arena, &idtable, &inttable, &stringtable, &floattable};
+  pipeline = new Pipeline;
+  pipeline->lexer = std::thread(run_lexer, pipeline, filename, curr_filename, tables);
+  if (pipeline->ring.front().kind == TOKEN_NO_INPUT) {
+    finish_pipeline();
+    return false;
+  }
+  // A fatal error, the lexer's or too many of the parser's, leaves
+  // seal_yyparse through input_error_jump; stop the lexer thread before
+  // passing it on, for it still holds this thread's string tables.
+  jmp_buf input_error, *outer = input_error_jump;
+  input_error_jump = &input_error;
+  int status = setjmp(input_error);
+  if (status != 0) {
+    input_error_jump = outer;
+    finish_pipeline();
+    fatal_input_error(status);
+  }
+  seal_yytoken_source = next_piped_token;
+  seal_yyparse();
+  input_error_jump = outer;
+  finish_pipeline();
+  return true;
+}
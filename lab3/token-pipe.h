@@ -0,0 +1,134 @@
+// -*-Mode: C++;-*-
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _TOKEN_PIPE_H_
+#define _TOKEN_PIPE_H_
+
+#include <atomic>
+#include <thread>
+#include "seal-parse.h"
+
+// If set, seal_yyparse calls this for each token instead of seal_yylex.
+// The function must set seal_yylval and curr_lineno as the lexer does.
+extern thread_local int (*seal_yytoken_source)();
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Token
+//
+//  What the lexer hands the parser: the token, its semantic value and
+//  the line the lexer was on.  A kind of 0 ends the input.
+//
+/////////////////////////////////////////////////////////////////////////
+
+struct Token
+{
+  int kind;
+  int line;
+  YYSTYPE value;
+};
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  TokenRing
+//
+//  A bounded queue of tokens from one producer thread to one consumer
+//  thread, without locks.  Only the producer moves tail and only the
+//  consumer moves head; each publishes its index with a release store
+//  that the other reads with an acquire load.  Each side also keeps the
+//  other's index as last seen, and reads it again only when the ring
+//  looks full or empty.  A side that has to wait yields the processor.
+//
+//  Token *slot()
+//      (producer) waits for a free slot and returns it, or returns NULL
+//      once the consumer has closed the ring.
+//
+//  void push()
+//      (producer) hands over the token written into the last slot.
+//
+//  const Token &front()
+//      (consumer) waits for the next token and returns it.
+//
+//  void pop()
+//      (consumer) frees the slot of the token front returned.
+//
+//  void close()
+//      (consumer) tells the producer no more tokens are wanted.
+//
+/////////////////////////////////////////////////////////////////////////
+
+class TokenRing
+{
+private:
+  enum { CAPACITY = 4096 };    // a power of two
+
+  Token tokens[CAPACITY];
+
+  alignas(64) std::atomic<unsigned> head;   // next token to take
+  unsigned tailSeen;                        // the consumer's copy of tail
+  alignas(64) std::atomic<unsigned> tail;   // next slot to fill
+  unsigned headSeen;                        // the producer's copy of head
+  std::atomic<bool> closed;
+
+public:
+  TokenRing() : head(0), tailSeen(0), tail(0), headSeen(0), closed(false) {}
+
+  Token *slot()
+  {
+    unsigned t = tail.load(std::memory_order_relaxed);
+    while (t - headSeen == CAPACITY) {
+      if (closed.load(std::memory_order_acquire))
+        return NULL;
+      headSeen = head.load(std::memory_order_acquire);
+      if (t - headSeen == CAPACITY)
+        std::this_thread::yield();
+    }
+    return &tokens[t & (CAPACITY - 1)];
+  }
+
+  void push()
+  {
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  const Token &front()
+  {
+    unsigned h = head.load(std::memory_order_relaxed);
+    while (h == tailSeen) {
+      tailSeen = tail.load(std::memory_order_acquire);
+      if (h == tailSeen)
+        std::this_thread::yield();
+    }
+    return tokens[h & (CAPACITY - 1)];
+  }
+
+  void pop()
+  {
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  void close()
+  {
+    closed.store(true, std::memory_order_release);
+  }
+};
+
+//
+// Parse filename like seal_yyparse, with the lexer on a thread of its
+// own filling a TokenRing, so that on large inputs lexing and parsing
+// overlap.  Returns false, without parsing, if the file cannot be read.
+// The AST, omerrs and curr_lineno end up as they would without the
+// pipeline, and so do the string tables: the lexer thread works on this
+// thread's tables, which this thread leaves alone until the lexer is
+// done.
+//
+// The lexer's fatal errors are held back until the parser reaches the
+// bad token, so diagnostics come out as without the pipeline.
+//
+bool parse_pipelined(char *filename);
+
+#endif
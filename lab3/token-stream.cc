@@ -0,0 +1,318 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "token-stream.h"
+#include "token-pipe.h"
+#include "stringtab.h"
+#include "utilities.h"
+
+extern thread_local FILE *fin;
+extern thread_local int curr_lineno;
+extern thread_local ostream *lex_errors;
+extern int seal_yyparse(void);
+extern int seal_yylex(void);
+extern int yylex_destroy(void);
+extern bool map_input_file(const char *filename);
+extern void unmap_input_file(void);
+
+static const char token_stream_magic[] = "SEALTOK1";
+#define MAGIC_LEN 8
+
+enum
+{
+  KIND_END = 0,
+  KIND_FATAL = 127,
+  KIND_MASK = 0x7F,
+  KIND_NEW_LINE = 0x80   // a line count follows
+};
+
+static_assert(TYPEID - 256 < ' ', "bison's tokens must not look like characters");
+
+//
+// Writing
+//
+
+static void put_varint(std::string &out, unsigned long n)
+{
+  while (n >= 0x80) {
+    out += (char)((n & 0x7F) | 0x80);
+    n >>= 7;
+  }
+  out += (char)n;
+}
+
+static void put_string(std::string &out, const char *s, int len)
+{
+  put_varint(out, len);
+  out.append(s, len);
+}
+
+template <class Elem>
+static void put_table(std::string &out, StringTable<Elem> &table)
+{
+  put_varint(out, table.size());
+  for (int i = table.first(); table.more(i); i = table.next(i)) {
+    Elem *e = table.lookup(i);
+    put_string(out, e->get_string(), e->get_len());
+  }
+}
+
+// Append a kind byte and the lines since line, which becomes the
+// current line.
+static void put_kind(std::string &out, int kind, int &line)
+{
+  if (curr_lineno == line) {
+    out += (char)kind;
+  } else {
+    out += (char)(kind | KIND_NEW_LINE);
+    put_varint(out, curr_lineno - line);
+    line = curr_lineno;
+  }
+}
+
+// Append the token seal_yylex just returned; line is the line of the
+// previous token.
+static void put_token(std::string &out, int kind, int &line)
+{
+  put_kind(out, kind < 256 ? kind : kind - 256, line);
+  switch (kind) {
+  case OBJECTID:
+  case TYPEID:
+  case CONST_INT:
+  case CONST_STRING:
+  case CONST_FLOAT:
+    put_varint(out, seal_yylval.symbol->get_index());
+    break;
+  case CONST_BOOL:
+    out += (char)(seal_yylval.boolean ? 1 : 0);
+    break;
+  }
+}
+
+// Append the tokens of the input up to its end.  Returns false if the
+// lexer stopped with a fatal error instead.
+static bool put_tokens(std::string &out, int &line)
+{
+  jmp_buf input_error;
+  input_error_jump = &input_error;
+  if (setjmp(input_error) != 0) {
+    input_error_jump = NULL;
+    return false;
+  }
+  int kind;
+  while ((kind = seal_yylex()) != 0)
+    put_token(out, kind, line);
+  input_error_jump = NULL;
+  return true;
+}
+
+bool write_token_stream(char *filename, ostream &out)
+{
+  fin = NULL;
+  if (!map_input_file(filename) && (fin = fopen(filename, "r")) == NULL)
+    return false;
+  curr_lineno = 1;
+  std::string tokens;
+  std::ostringstream errors;
+  int line = 1;
+  lex_errors = &errors;
+  bool ended = put_tokens(tokens, line);
+  lex_errors = &cerr;
+  unmap_input_file();
+  if (fin != NULL)
+    fclose(fin);
+  yylex_destroy();
+
+  put_kind(tokens, ended ? KIND_END : KIND_FATAL, line);
+  if (!ended)
+    put_string(tokens, errors.str().data(), errors.str().size());
+
+  std::string tables(token_stream_magic, MAGIC_LEN);
+  put_table(tables, idtable);
+  put_table(tables, inttable);
+  put_table(tables, stringtable);
+  put_table(tables, floattable);
+  out.write(tables.data(), tables.size());
+  out.write(tokens.data(), tokens.size());
+  return true;
+}
+
+//
+// Reading.  Every read is checked against the end of the data; once one
+// fails, the stream is taken to end there.
+//
+
+struct TokenStreamReader
+{
+  std::vector<char> data;
+  size_t pos;
+  bool broken;
+  bool ended;                       // the parser has been given the end
+  std::vector<Symbol> symbols[4];   // by table, in the order written
+
+  TokenStreamReader() : pos(0), broken(false), ended(false) {}
+
+  unsigned long varint()
+  {
+    unsigned long n = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (pos >= data.size())
+        break;
+      unsigned char b = data[pos++];
+      n |= (unsigned long)(b & 0x7F) << shift;
+      if (!(b & 0x80))
+        return n;
+    }
+    broken = true;
+    return 0;
+  }
+
+  int byte()
+  {
+    if (pos >= data.size()) {
+      broken = true;
+      return KIND_END;
+    }
+    return (unsigned char)data[pos++];
+  }
+
+  // a string of the stream; it stays in data
+  char *string(unsigned long &len)
+  {
+    len = varint();
+    if (broken || len > data.size() - pos) {
+      broken = true;
+      len = 0;
+      return NULL;
+    }
+    char *s = &data[pos];
+    pos += len;
+    return s;
+  }
+
+  template <class Elem>
+  void table(StringTable<Elem> &table, std::vector<Symbol> &symbols)
+  {
+    unsigned long count = varint();
+    for (unsigned long i = 0; i < count && !broken; i++) {
+      unsigned long len;
+      char *s = string(len);
+      if (!broken)
+        symbols.push_back(table.add_string(s, len));
+    }
+  }
+
+  Symbol symbol(int table)
+  {
+    unsigned long i = varint();
+    if (i >= symbols[table].size()) {
+      broken = true;
+      return NULL;
+    }
+    return symbols[table][i];
+  }
+};
+
+static thread_local TokenStreamReader *reader = NULL;
+
+static int next_stream_token()
+{
+  if (reader->ended)
+    return 0;
+  int b = reader->byte();
+  if (b & KIND_NEW_LINE)
+    curr_lineno += reader->varint();
+  b &= KIND_MASK;
+  if (reader->broken || b == KIND_END) {
+    reader->ended = true;
+    return 0;
+  }
+  if (b == KIND_FATAL) {
+    unsigned long len;
+    char *message = reader->string(len);
+    cerr.write(message, len);
+    fatal_input_error(-1);
+  }
+
+  int kind = b < ' ' ? b + 256 : b;
+  switch (kind) {
+  case OBJECTID:
+  case TYPEID:
+    seal_yylval.symbol = reader->symbol(0);
+    break;
+  case CONST_INT:
+    seal_yylval.symbol = reader->symbol(1);
+    break;
+  case CONST_STRING:
+    seal_yylval.symbol = reader->symbol(2);
+    break;
+  case CONST_FLOAT:
+    seal_yylval.symbol = reader->symbol(3);
+    break;
+  case CONST_BOOL:
+    seal_yylval.boolean = reader->byte() != 0;
+    break;
+  }
+  if (reader->broken) {
+    reader->ended = true;
+    return 0;
+  }
+  return kind;
+}
+
+bool is_token_stream(const char *filename)
+{
+  char magic[MAGIC_LEN];
+  FILE *f = fopen(filename, "rb");
+  if (f == NULL)
+    return false;
+  bool is = fread(magic, 1, MAGIC_LEN, f) == MAGIC_LEN &&
+            memcmp(magic, token_stream_magic, MAGIC_LEN) == 0;
+  fclose(f);
+  return is;
+}
+
+bool parse_token_stream(char *filename)
+{
+  std::ifstream in(filename, std::ios::binary | std::ios::ate);
+  if (!in)
+    return false;
+  reader = new TokenStreamReader;
+  reader->data.resize(in.tellg());
+  in.seekg(0);
+  in.read(reader->data.data(), reader->data.size());
+  reader->pos = MAGIC_LEN;
+  reader->table(idtable, reader->symbols[0]);
+  reader->table(inttable, reader->symbols[1]);
+  reader->table(stringtable, reader->symbols[2]);
+  reader->table(floattable, reader->symbols[3]);
+
+  curr_lineno = 1;
+  // A fatal error, the lexer's or too many of the parser's, leaves
+  // seal_yyparse through input_error_jump; drop the reader before
+  // passing it on.
+  jmp_buf input_error, *outer = input_error_jump;
+  input_error_jump = &input_error;
+  int status = setjmp(input_error);
+  if (status == 0) {
+    seal_yytoken_source = next_stream_token;
+    seal_yyparse();
+  }
+  input_error_jump = outer;
+  seal_yytoken_source = NULL;
+  delete reader;
+  reader = NULL;
+  if (status != 0)
+    fatal_input_error(status);
+  return true;
+}
@@ -0,0 +1,56 @@
+// -*-Mode: C++;-*-
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _TOKEN_STREAM_H_
+#define _TOKEN_STREAM_H_
+
+#include "seal-io.h"
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Token streams
+//
+//  The tokens of a source file, saved so that it can be parsed again
+//  without lexing it.  A stream is written once (semant -w) and then
+//  accepted wherever a source file is.
+//
+//  The format, where a number is an unsigned LEB128 varint:
+//
+//      "SEALTOK1"
+//      four string tables, in the order idtable, inttable, stringtable,
+//      floattable: the number of entries, then for each entry, in index
+//      order, its length and its characters
+//      the tokens, each a kind byte, then if the kind byte has its high
+//      bit set the number of lines since the previous token (or since
+//      line 1), then for some kinds a value:
+//          OBJECTID, TYPEID, CONST_INT, CONST_STRING, CONST_FLOAT
+//              the index of the Symbol in its table
+//          CONST_BOOL
+//              a byte, 0 or 1
+//      a last kind byte, 0 at the end of the input or 127 where the
+//      lexer stopped with a fatal error, with the number of lines as
+//      for a token and, for 127, the lexer's message as a string
+//
+//  The low seven bits of a kind byte are the token: a character token
+//  is itself (all are printable), and the others, which bison numbers
+//  from 258, are stored less 256.  Most tokens thus take one byte.
+//
+/////////////////////////////////////////////////////////////////////////
+
+// Lex filename and write its tokens to out.  Returns false if the file
+// cannot be read.
+bool write_token_stream(char *filename, ostream &out);
+
+// Whether filename starts like a token stream.
+bool is_token_stream(const char *filename);
+
+// Parse the token stream in filename like seal_yyparse would parse the
+// source it was written from, diagnostics included.  Returns false if
+// the file cannot be read.  A stream cut short ends where it breaks off.
+bool parse_token_stream(char *filename);
+
+#endif
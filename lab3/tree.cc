@@ -16,7 +16,10 @@
 #include "tree.h"
 
 /* line number to assign to the current node being constructed */
-int node_lineno = 1;
+thread_local int node_lineno = 1;
+
+/* storage of all tree nodes */
+thread_local Arena tree_arena;
 
 ///////////////////////////////////////////////////////////////////////////
 //
@@ -28,6 +31,7 @@ int node_lineno = 1;
 tree_node::tree_node()
 {
     line_number = node_lineno;
+    kind = NODE_LIST;
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -15,9 +15,65 @@
 ///////////////////////////////////////////////////////////////////////////
  
 
+#include <new>
+#include <vector>
+#include "arena.h"
 #include "stringtab.h"
 #include "seal-io.h"
 
+/////////////////////////////////////////////////////////////////////
+//
+//  tree_arena
+//
+//   Every tree_node, and the element array of every list, is allocated
+//   from tree_arena.  Nodes built one after another sit next to each
+//   other in memory.  Nodes are never freed one by one: when a
+//   compilation is finished, tree_arena.release() frees the whole AST.
+//
+//   tree_allocator lets standard containers allocate from tree_arena.
+//
+/////////////////////////////////////////////////////////////////////
+extern thread_local Arena tree_arena;
+
+template <class T> class tree_allocator {
+public:
+    typedef T value_type;
+    tree_allocator() { }
+    template <class U> tree_allocator(const tree_allocator<U> &) { }
+    T *allocate(size_t n)        { return (T *) tree_arena.alloc(n * sizeof(T)); }
+    void deallocate(T *, size_t) { }
+};
+
+template <class T, class U>
+bool operator==(const tree_allocator<T> &, const tree_allocator<U> &) { return true; }
+template <class T, class U>
+bool operator!=(const tree_allocator<T> &, const tree_allocator<U> &) { return false; }
+
+/////////////////////////////////////////////////////////////////////
+//
+//  NodeKind
+//
+//   Every tree_node carries a one-byte tag naming its concrete class.
+//   Lists all share NODE_LIST.  A pass that needs to tell node classes
+//   apart can switch on get_kind() instead of making a virtual call
+//   per node (see seal-visitor.h).
+//
+/////////////////////////////////////////////////////////////////////
+enum NodeKind : unsigned char {
+    NODE_LIST,
+    NODE_PROGRAM, NODE_VARIABLE, NODE_VARIABLE_DECL, NODE_CALL_DECL,
+    NODE_STMT_BLOCK, NODE_IF, NODE_WHILE, NODE_FOR, NODE_RETURN,
+    NODE_CONTINUE, NODE_BREAK,
+    NODE_CALL, NODE_ACTUAL, NODE_ASSIGN,
+    NODE_ADD, NODE_MINUS, NODE_MULTI, NODE_DIVIDE, NODE_MOD, NODE_NEG,
+    NODE_LT, NODE_LE, NODE_EQU, NODE_NEQ, NODE_GE, NODE_GT,
+    NODE_AND, NODE_OR, NODE_XOR, NODE_NOT,
+    NODE_BITNOT, NODE_BITAND, NODE_BITOR,
+    NODE_CONST_INT, NODE_CONST_STRING, NODE_CONST_FLOAT, NODE_CONST_BOOL,
+    NODE_OBJECT, NODE_NO_EXPR,
+    NODE_KIND_COUNT
+};
+
 /////////////////////////////////////////////////////////////////////
 //
 //  tree_node
@@ -27,6 +83,8 @@
 //       int line_number     line in the source file from which this node came;
 //                           this is read from a global variable when the
 //                           node is created.
+//       NodeKind kind       the concrete class of the node.  It is NODE_LIST
+//                           unless the constructor of a node class sets it.
 //      
 //
 //
@@ -41,24 +99,33 @@
 //         the number of spaces to indent the output.
 //
 //       int get_line_number();  return the line number
+//       NodeKind get_kind();    return the node kind
 //       Symbol get_type();      return the type 
 //
 //       tree_node *set(tree_node *t)
 //           sets the line number and type of "this" to the values in
 //           the argument tree_node.  Returns "this".
 //
+//   operator new places every node in tree_arena; operator delete
+//   does nothing, since the arena is released as a whole.
+//
 //
 ////////////////////////////////////////////////////////////////////////////
 class tree_node {
 protected:
     int line_number;            // stash the line number when node is made
+    NodeKind kind;              // concrete class of the node
 public:
     tree_node();
     virtual tree_node *copy() = 0;
     virtual ~tree_node() { }
     virtual void dump(ostream& stream, int n) = 0;
     int get_line_number();
+    NodeKind get_kind() { return kind; }
     tree_node *set(tree_node *);
+
+    static void *operator new(size_t size) { return tree_arena.alloc(size); }
+    static void operator delete(void *) { }
 };
 
 ///////////////////////////////////////////////////////////////////
@@ -89,6 +156,14 @@ public:
 //     for(int i = l->first(); l->more(i); i = l->next(i))
 //         ... operate on l->nth(i) ...
 //
+//     iterator begin();
+//     iterator end();
+//       Iterators over the list elements in order, so that a list can be
+//     walked with a range-based for loop in one pass over its storage:
+//
+//     for(Elem e : *l)
+//         ... operate on e ...
+//
 //      
 //     int len()
 //     returns the length of the list
@@ -98,6 +173,13 @@ public:
 //     "len" is set to the length of the list.  This method is used internally
 //     by the APS package to efficiently traverse the list representation.  
 //
+//     A list is a view (start, length) of a contiguous array of elements,
+//     so nth, len and more take constant time.  Arrays are shared between
+//     lists: appending to a list whose view ends at the end of its array
+//     (as the parser's append_* helpers always do) extends that array in
+//     place, and only appending to an older, shorter view copies it.
+//     Existing views never change.
+//
 //     static list_node<Elem> *nil();
 //     static list_node<Elem> *single(Elem);
 //     static list_node<Elem> *append(list_node<Elem> *, list_node<Elem> *);
@@ -113,6 +195,20 @@ public:
 //////////////////////////////////////////////////////////////////////////////
 
 template <class Elem> class list_node : public tree_node {
+protected:
+    typedef std::vector<Elem, tree_allocator<Elem> > elem_array;
+
+    elem_array *elems;          // element array, possibly shared
+    int start;                  // index of the first element in *elems
+    int length;                 // number of elements in this list
+
+    static elem_array *new_array() {
+        return new (tree_arena.alloc(sizeof(elem_array))) elem_array();
+    }
+
+    list_node() : elems(NULL), start(0), length(0) { }
+    list_node(elem_array *v) : elems(v), start(0), length(v->size()) { }
+    list_node(list_node<Elem> *l1, list_node<Elem> *l2);
 public:
     tree_node *copy()            { return copy_list(); }
     Elem nth(int n);
@@ -121,12 +217,19 @@ public:
     //
     int first()      { return 0; }
     int next(int n)  { return n + 1; }
-    int more(int n)  { return (n < len()); }
+    int more(int n)  { return (n < length); }
+
+    //
+    // Iterators for range-based for loops.
+    //
+    typedef Elem *iterator;
+    iterator begin() { return length ? &(*elems)[start] : NULL; }
+    iterator end()   { return begin() + length; }
 
     virtual list_node<Elem> *copy_list() = 0;
     virtual ~list_node() { }
-    virtual int len() = 0;
-    virtual Elem nth_length(int n, int &len) = 0;
+    int len()        { return length; }
+    Elem nth_length(int n, int &len);
 
     static list_node<Elem> *nil();
     static list_node<Elem> *single(Elem);
@@ -140,36 +243,27 @@ extern int info_size;
 template <class Elem> class nil_node : public list_node<Elem> {
 public:
     list_node<Elem> *copy_list();
-    int len();
-    Elem nth_length(int n, int &len);
     void dump(ostream& stream, int n);
 };
 
 template <class Elem> class single_list_node : public list_node<Elem> {
-    Elem elem;
 public:
-    single_list_node(Elem t) {
-	elem = t;
+    single_list_node(Elem t) : list_node<Elem>(list_node<Elem>::new_array()) {
+	this->elems->push_back(t);
+	this->length = 1;
     }
     list_node<Elem> *copy_list();
-    int len();
-    Elem nth_length(int n, int &len);
     void dump(ostream& stream, int n);
 };
 
 
 template <class Elem> class append_node : public list_node<Elem> {
 private:
-    list_node<Elem> *some, *rest;
+    append_node(typename list_node<Elem>::elem_array *v) : list_node<Elem>(v) { }
 public:
-    append_node(list_node<Elem> *l1, list_node<Elem> *l2) {
-	some = l1;
-	rest = l2;
-    }
+    append_node(list_node<Elem> *l1, list_node<Elem> *l2)
+        : list_node<Elem>(l1, l2) { }
     list_node<Elem> *copy_list();
-    int len();
-    Elem nth(int n);
-    Elem nth_length(int n, int &len);
     void dump(ostream& stream, int n);
 };
 
@@ -188,77 +282,91 @@ template <class Elem> list_node<Elem> *list_node<Elem>::append(list_node<Elem> *
 
 ///////////////////////////////////////////////////////////////////////////
 //
-// list_node::nth
+// list_node::list_node
 //
-// function to find the nth element of the list
+// construct the list l1 followed by l2
 //
 ///////////////////////////////////////////////////////////////////////////
 
-template <class Elem> Elem list_node<Elem>::nth(int n)
+template <class Elem> list_node<Elem>::list_node(list_node<Elem> *l1,
+                                                 list_node<Elem> *l2)
 {
-    int len;
-    Elem tmp = nth_length(n ,len);
-
-    if (tmp)
-	return tmp;
-    else {
-	cerr << "error: outside the range of the list\n";
-	exit(1);
+    list_node<Elem> *view = l2->length ? l1->length ? NULL : l2 : l1;
+
+    if (view) {
+	// one side is empty; share the other side's view
+	elems = view->elems;
+	start = view->start;
+	length = view->length;
+	return;
     }
-}
-
-// added 10/30/06 cgs
-template <class Elem> Elem append_node<Elem>::nth(int n)
-{
-    int len;
-    Elem tmp = nth_length(n ,len);
 
-    if (tmp)
-	return tmp;
-    else {
-	cerr << "error: outside the range of the list\n";
-	exit(1);
+    if (l1->start + l1->length == (int) l1->elems->size()) {
+	// l1 ends its array, so the array can be extended in place
+	elems = l1->elems;
+	start = l1->start;
+    } else {
+	elems = new_array();
+	elems->assign(l1->elems->begin() + l1->start,
+		      l1->elems->begin() + l1->start + l1->length);
+	start = 0;
     }
+    length = l1->length + l2->length;
+
+    // l2 may share the array being extended, so index rather than iterate.
+    // Grow geometrically: reserve() alone would allocate exactly, and
+    // every append to a long list would copy it again.
+    size_t need = start + length;
+    if (elems->capacity() < need)
+	elems->reserve(need > 2 * elems->capacity() ? need : 2 * elems->capacity());
+    for (int i = 0; i < l2->length; i++)
+	elems->push_back((*l2->elems)[l2->start + i]);
 }
 
 ///////////////////////////////////////////////////////////////////////////
 //
-// nil_node::copy_list
+// list_node::nth
 //
-// return the deep copy of the nil_node
+// function to find the nth element of the list
 //
 ///////////////////////////////////////////////////////////////////////////
-template <class Elem> list_node<Elem> *nil_node<Elem>::copy_list()
+
+template <class Elem> Elem list_node<Elem>::nth(int n)
 {
-    return new nil_node<Elem>();
+    if (0 <= n && n < length)
+	return (*elems)[start + n];
+    else {
+	cerr << "error: outside the range of the list\n";
+	exit(1);
+    }
 }
 
-
 ///////////////////////////////////////////////////////////////////////////
 //
-// nil_node::len
+// list_node::nth_length
 //
-// return the length of the nil_node
+// return the nth element on the list
 //
 ///////////////////////////////////////////////////////////////////////////
-template <class Elem> int nil_node<Elem>::len()
+template <class Elem> Elem list_node<Elem>::nth_length(int n, int &len)
 {
-    return 0;
+    len = length;
+    if (0 <= n && n < length)
+	return (*elems)[start + n];
+    else
+	return NULL;
 }
 
-
-
 ///////////////////////////////////////////////////////////////////////////
 //
-// nil_node::nth_length
+// nil_node::copy_list
 //
-// return the nth element on the list
+// return the deep copy of the nil_node
 //
 ///////////////////////////////////////////////////////////////////////////
-template <class Elem> Elem nil_node<Elem>::nth_length(int, int &len)
+template <class Elem> list_node<Elem> *nil_node<Elem>::copy_list()
 {
-    len = 0;
-    return NULL;
+    return new nil_node<Elem>();
 }
 
 
@@ -284,37 +392,7 @@ template <class Elem> void nil_node<Elem>::dump(ostream& stream, int n)
 ///////////////////////////////////////////////////////////////////////////
 template <class Elem> list_node<Elem> *single_list_node<Elem>::copy_list()
 {
-    return new single_list_node<Elem>((Elem) elem->copy());
-}
-
-
-///////////////////////////////////////////////////////////////////////////
-//
-// single_list_node::len
-//
-// return the length of the single_list_node
-//
-///////////////////////////////////////////////////////////////////////////
-template <class Elem> int single_list_node<Elem>::len()
-{
-    return 1;
-}
-
-
-///////////////////////////////////////////////////////////////////////////
-//
-// single_list_node::nth_length
-//
-// return the nth element on the list
-//
-///////////////////////////////////////////////////////////////////////////
-template <class Elem> Elem single_list_node<Elem>::nth_length(int n, int &len)
-{
-    len = 1;
-    if (n)
-	return NULL;
-    else
-	return elem;
+    return new single_list_node<Elem>((Elem) this->nth(0)->copy());
 }
 
 
@@ -327,7 +405,7 @@ template <class Elem> Elem single_list_node<Elem>::nth_length(int n, int &len)
 ///////////////////////////////////////////////////////////////////////////
 template <class Elem> void single_list_node<Elem>::dump(ostream& stream, int n)
 {
-    elem->dump(stream, n);
+    this->nth(0)->dump(stream, n);
 }
 
 
@@ -340,40 +418,12 @@ template <class Elem> void single_list_node<Elem>::dump(ostream& stream, int n)
 ///////////////////////////////////////////////////////////////////////////
 template <class Elem> list_node<Elem> *append_node<Elem>::copy_list()
 {
-    return new append_node<Elem>(some->copy_list(), rest->copy_list());
-}
-
-
-///////////////////////////////////////////////////////////////////////////
-//
-// append_node::len
-//
-// return the length of the append_node
-//
-///////////////////////////////////////////////////////////////////////////
-template <class Elem> int append_node<Elem>::len()
-{
-    return some->len() + rest->len();
-}
-
-
-///////////////////////////////////////////////////////////////////////////
-//
-// append_node::nth_length
-//
-// return the nth element on the list
-//
-///////////////////////////////////////////////////////////////////////////
-template <class Elem> Elem append_node<Elem>::nth_length(int n, int &len)
-{
-    int rlen;
-    Elem tmp = some->nth_length(n, len);
+    typename list_node<Elem>::elem_array *v = this->new_array();
 
-    if (!tmp) {
-	tmp = rest->nth_length(n-len, rlen);
-	len += rlen;
-    }
-    return tmp;
+    v->reserve(this->length);
+    for (int i = 0; i < this->length; i++)
+	v->push_back((Elem) this->nth(i)->copy());
+    return new append_node<Elem>(v);
 }
 
 
@@ -388,10 +438,10 @@ template <class Elem> void append_node<Elem>::dump(ostream& stream, int n)
 {
     int i, size;
 
-    size = len();
+    size = this->len();
     stream << pad(n) << "list\n";
     for (i = 0; i < size; i++)
-      nth(i)->dump(stream, n+2);
+      this->nth(i)->dump(stream, n+2);
     stream << pad(n) << "(end_of_list)\n";
 }
 
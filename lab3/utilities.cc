@@ -12,6 +12,8 @@
 //
 //  This file contains:
 //      fatal_error            print an error message and exit
+//      fatal_input_error      give up on the input after a lexer or
+//                             parser error that cannot be recovered from
 //      print_escaped_string   print a string showing escape characters
 //      print_seal_token       print a seal token and its semantic value
 //      dump_seal_token        dump a readable token representation
@@ -39,6 +41,18 @@ void fatal_error(char *msg)
    exit(1);
 }
 
+// The compile server sets this to go on with the next request instead
+// of exiting; see semant-server.cc.  setjmp returns the status, which is
+// never 0.
+thread_local jmp_buf *input_error_jump = NULL;
+
+void fatal_input_error(int status)
+{
+   if (input_error_jump)
+      longjmp(*input_error_jump, status != 0 ? status : 1);
+   exit(status);
+}
+
 
 void print_escaped_string(ostream& str, const char *s)
 {
@@ -8,11 +8,14 @@
 #ifndef _UTILITIES_H_
 #define _UTILITIES_H_
 
+#include <setjmp.h>
 #include "seal-io.h"
 
 extern char *seal_token_to_string(int tok);
 extern void print_seal_token(int tok);
 extern void fatal_error(char *);
+extern thread_local jmp_buf *input_error_jump;
+extern void fatal_input_error(int status);
 extern void print_escaped_string(ostream& str, const char *s);
 extern char *pad(int);
 /*  On some machines strdup is not in the standard library. */